@@ -0,0 +1,244 @@
+#include <Arduino.h>
+#include <LowcostRC_ADC.h>
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <Ticker.h>
+
+#define ADC_SAMPLE_INTERVAL 10
+#endif
+
+struct ADCChannel {
+  uint8_t pin,
+          mux,
+          filterShift,
+          oversampleBits;
+  volatile bool isValid;
+  volatile uint16_t value;
+};
+
+static ADCChannel channels[ADC_SAMPLER_CHANNELS];
+static volatile uint8_t numChannels = 0;
+static int8_t bandgapSlot = ADC_SLOT_NONE;
+static bool isStarted = false;
+
+// Snapshot taken when the last slot completes
+static volatile uint16_t setValues[ADC_SAMPLER_CHANNELS];
+static volatile unsigned long setTime = 0;
+static volatile uint8_t setCount = 0;
+
+static void updateSet() {
+  for (uint8_t i = 0; i < numChannels; i++)
+    setValues[i] = channels[i].value;
+  setTime = micros();
+  setCount++;
+}
+
+static void updateChannel(ADCChannel *ch, uint16_t sum) {
+  uint16_t fine = sum << (ADC_FINE_BITS - ch->oversampleBits);
+
+  if (!ch->isValid || ch->filterShift == 0) {
+    ch->value = fine;
+    ch->isValid = true;
+  } else {
+    ch->value += ((int16_t)(fine - ch->value)) >> ch->filterShift;
+  }
+}
+
+#ifdef ARDUINO_ARCH_AVR
+
+// Conversions discarded after input switch
+#define ADC_DISCARD 1
+#define ADC_BANDGAP_DISCARD 4
+
+#if defined(__AVR_ATmega32U4__)
+#define BANDGAP_MUX (_BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1))
+#else
+#define BANDGAP_MUX (_BV(MUX3) | _BV(MUX2) | _BV(MUX1))
+#endif
+
+static uint8_t current = 0,
+               discard = 0,
+               count = 0;
+static uint16_t sum = 0;
+
+static uint8_t pinToMux(uint8_t pin) {
+  if (pin == ADC_BANDGAP) return BANDGAP_MUX;
+#if defined(__AVR_ATmega32U4__)
+  if (pin >= 18) pin -= 18;
+  pin = analogPinToChannel(pin);
+  // Bit 5 selects MUX5 in ADCSRB
+  return (pin & 0x07) | ((pin & 0x08) << 2);
+#else
+  if (pin >= 14) pin -= 14;
+  return pin;
+#endif
+}
+
+static void selectInput(uint8_t slot) {
+  uint8_t mux = channels[slot].mux;
+
+#if defined(ADCSRB) && defined(MUX5)
+  ADCSRB = (ADCSRB & ~_BV(MUX5)) | (((mux >> 5) & 0x01) << MUX5);
+#endif
+  ADMUX = _BV(REFS0) | (mux & 0x1f);
+  discard = channels[slot].pin == ADC_BANDGAP ? ADC_BANDGAP_DISCARD : ADC_DISCARD;
+}
+
+// Next conversion starts only at the end, so this can't nest. Timer
+// interrupts, like pulse outputs, run without waiting for it.
+ISR(ADC_vect, ISR_NOBLOCK) {
+  uint16_t sample = ADC;
+
+  if (discard > 0) {
+    discard--;
+  } else {
+    sum += sample;
+    if (++count == (1 << channels[current].oversampleBits)) {
+      updateChannel(&channels[current], sum);
+      sum = 0;
+      count = 0;
+      if (++current >= numChannels) {
+        current = 0;
+        updateSet();
+      }
+      selectInput(current);
+    }
+  }
+
+  ADCSRA |= _BV(ADSC);
+}
+
+#elif defined(ARDUINO_ARCH_ESP8266)
+
+static Ticker ticker;
+static uint8_t current = 0;
+
+// One slot per tick, analogRead() blocks
+static void sample() {
+  ADCChannel *ch = &channels[current];
+  uint16_t sum = 0;
+
+  for (uint8_t i = 0; i < (1 << ch->oversampleBits); i++)
+    sum += analogRead(ch->pin);
+  updateChannel(ch, sum);
+  if (++current >= numChannels) {
+    current = 0;
+    updateSet();
+  }
+}
+
+#endif
+
+int8_t ADCSampler::addChannel(uint8_t pin, uint8_t filterShift, uint8_t oversampleBits) {
+  ADCChannel *ch;
+  int8_t slot;
+
+  for (slot = 0; slot < numChannels; slot++)
+    if (channels[slot].pin == pin)
+      return slot;
+
+#ifdef ARDUINO_ARCH_ESP8266
+  if (pin == ADC_BANDGAP) return ADC_SLOT_NONE;
+#endif
+  if (numChannels >= ADC_SAMPLER_CHANNELS) return ADC_SLOT_NONE;
+
+#ifdef ARDUINO_ARCH_AVR
+  uint8_t oldSREG = SREG;
+  cli();
+#endif
+  ch = &channels[slot];
+  ch->pin = pin;
+#ifdef ARDUINO_ARCH_AVR
+  ch->mux = pinToMux(pin);
+#endif
+  ch->filterShift = filterShift;
+  ch->oversampleBits = min(oversampleBits, (uint8_t)ADC_OVERSAMPLE_BITS_MAX);
+  ch->isValid = false;
+  ch->value = 0;
+#ifdef ARDUINO_ARCH_ESP8266
+  // Seed, so the value is valid before the first round completes
+  updateChannel(ch, analogRead(pin) << ch->oversampleBits);
+  setValues[slot] = ch->value;
+#endif
+  numChannels++;
+#ifdef ARDUINO_ARCH_AVR
+  SREG = oldSREG;
+#endif
+
+  if (pin == ADC_BANDGAP) bandgapSlot = slot;
+  return slot;
+}
+
+void ADCSampler::begin() {
+  if (isStarted || numChannels == 0) return;
+  isStarted = true;
+
+#ifdef ARDUINO_ARCH_AVR
+  current = 0;
+  count = 0;
+  sum = 0;
+  selectInput(current);
+  ADCSRA |= _BV(ADEN) | _BV(ADIE);
+  ADCSRA |= _BV(ADSC);
+
+  // Let the first round complete, so readers never see empty values
+  while (!channels[numChannels - 1].isValid);
+#elif defined(ARDUINO_ARCH_ESP8266)
+  current = 0;
+  ticker.attach_ms(ADC_SAMPLE_INTERVAL, sample);
+#endif
+}
+
+uint16_t ADCSampler::readFine(int8_t slot) {
+  uint16_t value;
+
+  if (slot < 0) return 0;
+#ifdef ARDUINO_ARCH_AVR
+  uint8_t oldSREG = SREG;
+  cli();
+  value = channels[slot].value;
+  SREG = oldSREG;
+#else
+  value = channels[slot].value;
+#endif
+  return value;
+}
+
+uint16_t ADCSampler::read(int8_t slot) {
+  return (readFine(slot) + (1 << (ADC_FINE_BITS - 1))) >> ADC_FINE_BITS;
+}
+
+uint8_t ADCSampler::getSetCount() {
+  return setCount;
+}
+
+uint8_t ADCSampler::readSet(uint16_t *values, unsigned long *time) {
+  uint8_t count;
+
+#ifdef ARDUINO_ARCH_AVR
+  uint8_t oldSREG = SREG;
+  cli();
+#endif
+  for (uint8_t i = 0; i < numChannels; i++)
+    values[i] = setValues[i];
+  if (time != NULL) *time = setTime;
+  count = setCount;
+#ifdef ARDUINO_ARCH_AVR
+  SREG = oldSREG;
+#endif
+  return count;
+}
+
+unsigned int ADCSampler::readVccMillivolts() {
+#ifdef ARDUINO_ARCH_AVR
+  uint16_t bandgap = readFine(bandgapSlot);
+
+  if (bandgap == 0) return 0;
+  // 1.1 * 1023 * 1000 = 1125300
+  return (1125300L << ADC_FINE_BITS) / bandgap;
+#else
+  return 1000;
+#endif
+}
+
+// vim:ai:sw=2:et
@@ -0,0 +1,45 @@
+#ifndef LOWCOSTRC_ADC_H
+#define LOWCOSTRC_ADC_H
+
+#include <Arduino.h>
+
+#define ADC_SAMPLER_CHANNELS 8
+#define ADC_SLOT_NONE -1
+// Pseudo pin for internal 1.1V reference
+#define ADC_BANDGAP 0xff
+
+// Default conversions summed per value, as power of 2. Every 4x
+// oversampling adds 1 bit of resolution when input has some noise.
+#define ADC_OVERSAMPLE_BITS 2
+#define ADC_OVERSAMPLE_BITS_MAX 4
+
+// Values are kept with 4 fractional bits
+#define ADC_FINE_BITS 4
+
+// Samples registered ADC pins in background, round robin. AVR conversions
+// are chained from ADC complete interrupt, ESP8266 samples one slot per
+// Ticker tick. Once started, analogRead() must not be used.
+class ADCSampler {
+  public:
+    // Returns slot or ADC_SLOT_NONE. Larger filterShift smooths more, 0
+    // only oversamples.
+    static int8_t addChannel(
+      uint8_t pin,
+      uint8_t filterShift = 0,
+      uint8_t oversampleBits = ADC_OVERSAMPLE_BITS
+    );
+    static void begin();
+    // Latest value, 0..1023
+    static uint16_t read(int8_t slot);
+    // Latest value with ADC_FINE_BITS fractional bits
+    static uint16_t readFine(int8_t slot);
+    static unsigned int readVccMillivolts();
+    // Number of completed rounds over all slots, wraps
+    static uint8_t getSetCount();
+    // Fine values of all slots from the same round, indexed by slot, and
+    // micros() of round end. Returns set count.
+    static uint8_t readSet(uint16_t *values, unsigned long *time = NULL);
+};
+
+#endif // LOWCOSTRC_ADC_H
+// vim:ai:sw=2:et
@@ -3,7 +3,7 @@
 
 #include <Arduino.h>
 
-const size_t PACKET_SIZE = 18;
+const size_t PACKET_SIZE = 19;
 
 #define ADDRESS_LENGTH 6
 #define ADDRESS_NONE {{0, 0, 0, 0, 0, 0}}
@@ -11,6 +11,10 @@ const size_t PACKET_SIZE = 18;
 #define DEFAULT_RF_CHANNEL 0
 #define DEFAULT_PA_LEVEL 0
 
+// Transmitter resends control packet at least this often (ms) even if
+// nothing changed, receiver failsafe timing relies on it
+#define CONTROL_PING_INTERVAL 100
+
 enum PacketTypeEnum {
   PACKET_TYPE_CONTROL = 0x0a01,
   PACKET_TYPE_TELEMETRY = 0x0a02,
@@ -18,6 +22,11 @@ enum PacketTypeEnum {
   PACKET_TYPE_SET_PA_LEVEL = 0x0a04,
   PACKET_TYPE_PAIR = 0x0a05,
   PACKET_TYPE_COMMAND = 0x0a06,
+  PACKET_TYPE_TIMING_STATS = 0x0a07,
+  PACKET_TYPE_SENSORS = 0x0a08,
+  PACKET_TYPE_RF_SCAN = 0x0a09,
+  PACKET_TYPE_PING = 0x0a0a,
+  PACKET_TYPE_PONG = 0x0a0b,
 };
 
 typedef uint16_t PacketType;
@@ -41,6 +50,8 @@ enum CommandEnum {
   COMMAND_SAVE_FAILSAFE,
   COMMAND_USER_COMMAND1,
   COMMAND_USER_COMMAND2,
+  // Receiver measures channel occupancy and reports it in RF_SCAN packets
+  COMMAND_SCAN_RF,
 };
 
 typedef uint16_t Command;
@@ -53,6 +64,39 @@ enum PairStatusEnum {
 
 typedef uint8_t PairStatus;
 
+enum TimingProbeEnum {
+  TIMING_PROBE_RECEIVE,
+  TIMING_PROBE_HANDLE_PACKET,
+  TIMING_PROBE_APPLY,
+  // From packet arrival to outputs written
+  TIMING_PROBE_LATENCY,
+  TIMING_PROBE_LOOP,
+  NUM_TIMING_PROBES,
+};
+
+typedef uint8_t TimingProbe;
+
+#define TIMING_STATS_PACKET_BUCKETS 8
+
+// Sensor values units: mA, 0.1 C, RPM, us, us
+enum SensorTypeEnum {
+  SENSOR_TYPE_NONE,
+  SENSOR_TYPE_CURRENT,
+  SENSOR_TYPE_TEMPERATURE,
+  SENSOR_TYPE_RPM,
+  SENSOR_TYPE_LOOP_TIME,
+  // Packet received to output, e.g. USB report of simulator receiver
+  SENSOR_TYPE_LATENCY,
+  // Percent of frames received by diversity path, path number is added
+  SENSOR_TYPE_PATH_QUALITY = 0x10,
+};
+
+typedef uint8_t SensorType;
+
+#define SENSORS_PACKET_VALUES 5
+
+#define RF_SCAN_PACKET_CHANNELS 16
+
 struct Address {
   uint8_t address[ADDRESS_LENGTH];
 } __attribute__((__packed__));
@@ -67,6 +111,8 @@ struct GenericPacket {
 struct ControlPacket {
   PacketType packetType;
   uint16_t channels[NUM_CHANNELS];
+  // Incremented for every sent frame, lets receivers drop duplicates
+  uint8_t sequence;
 } __attribute__((__packed__));
 
 struct TelemetryPacket {
@@ -96,6 +142,46 @@ struct PairPacket {
   Address sender;
 } __attribute__((__packed__));
 
+// Times in microseconds, buckets are shares 0..255 of log2 histogram
+struct TimingStatsPacket {
+  PacketType packetType;
+  TimingProbe probe;
+  uint16_t minValue,
+           avgValue,
+           maxValue;
+  uint8_t buckets[TIMING_STATS_PACKET_BUCKETS];
+} __attribute__((__packed__));
+
+struct SensorValue {
+  SensorType type;
+  int16_t value;
+} __attribute__((__packed__));
+
+struct SensorsPacket {
+  PacketType packetType;
+  SensorValue values[SENSORS_PACKET_VALUES];
+} __attribute__((__packed__));
+
+struct RFScanPacket {
+  PacketType packetType;
+  RFChannel firstChannel;
+  uint8_t hits[RF_SCAN_PACKET_CHANNELS];
+} __attribute__((__packed__));
+
+// Times are micros() of the sending side
+struct PingPacket {
+  PacketType packetType;
+  uint32_t txTime;
+} __attribute__((__packed__));
+
+// rxTime when the ping was received, replyTime when the pong was sent
+struct PongPacket {
+  PacketType packetType;
+  uint32_t txTime,
+           rxTime,
+           replyTime;
+} __attribute__((__packed__));
+
 union RequestPacket {
   struct GenericPacket generic;
   struct ControlPacket control;
@@ -103,12 +189,17 @@ union RequestPacket {
   struct SetPALevelPacket paLevel;
   struct CommandPacket command;
   struct PairPacket pair;
+  struct PingPacket ping;
 };
 
 union ResponsePacket {
   struct GenericPacket generic;
   struct TelemetryPacket telemetry;
   struct PairPacket pair;
+  struct TimingStatsPacket timingStats;
+  struct SensorsPacket sensors;
+  struct RFScanPacket rfScan;
+  struct PongPacket pong;
 };
 
 #endif // LowcostRC_Protocol_h
@@ -0,0 +1,72 @@
+#include <string.h>
+#include <LowcostRC_RFScan.h>
+
+RFScan::RFScan()
+  : channel(0),
+    sweep(RF_SCAN_SWEEPS)
+{
+  memset(hits, 0, sizeof(hits));
+}
+
+void RFScan::start() {
+  memset(hits, 0, sizeof(hits));
+  channel = 1;
+  sweep = 0;
+}
+
+bool RFScan::isRunning() {
+  return sweep < RF_SCAN_SWEEPS;
+}
+
+uint8_t RFScan::getProgress() {
+  if (!isRunning()) return 100;
+  return (sweep * (RF_SCAN_CHANNELS - 1) + channel - 1) * 100L
+    / (RF_SCAN_SWEEPS * (RF_SCAN_CHANNELS - 1));
+}
+
+RFChannel RFScan::getChannel() {
+  return channel;
+}
+
+void RFScan::add(bool isBusy) {
+  if (!isRunning()) return;
+
+  if (isBusy) hits[channel]++;
+  if (++channel >= RF_SCAN_CHANNELS) {
+    channel = 1;
+    sweep++;
+  }
+}
+
+void RFScan::merge(RFChannel first, const uint8_t *values, uint8_t count) {
+  for (uint8_t i = 0; i < count && first + i < RF_SCAN_CHANNELS; i++)
+    hits[first + i] = min(hits[first + i] + values[i], 0xff);
+}
+
+RFChannel RFScan::getQuietest() {
+  RFChannel best = 1;
+  uint16_t bestNoise = 0xffff, noise;
+
+  for (int ch = 1; ch < RF_SCAN_CHANNELS; ch++) {
+    noise = 0;
+    for (int i = ch - RF_SCAN_WINDOW; i <= ch + RF_SCAN_WINDOW; i++)
+      if (i >= 1 && i < RF_SCAN_CHANNELS)
+        noise += hits[i];
+    if (noise < bestNoise) {
+      bestNoise = noise;
+      best = ch;
+    }
+  }
+
+  return best;
+}
+
+uint8_t RFScan::getMaxHits(RFChannel first, uint8_t count) {
+  uint8_t value = 0;
+
+  for (uint8_t i = 0; i < count && first + i < RF_SCAN_CHANNELS; i++)
+    value = max(value, hits[first + i]);
+  return value;
+}
+
+// vim:ai:sw=2:et
@@ -0,0 +1,35 @@
+#ifndef LOWCOSTRC_RFSCAN_H
+#define LOWCOSTRC_RFSCAN_H
+
+#include <LowcostRC_Protocol.h>
+
+// nRF24 channels, 0 is the default channel alias and is not scanned
+#define RF_SCAN_CHANNELS 126
+#define RF_SCAN_SWEEPS 8
+// Neighbour channels on each side counted to channel noise
+#define RF_SCAN_WINDOW 2
+
+// Occupancy histogram, counts sweeps with carrier detected per channel
+class RFScan {
+  private:
+    RFChannel channel;
+    uint8_t sweep;
+  public:
+    uint8_t hits[RF_SCAN_CHANNELS];
+
+    RFScan();
+    void start();
+    bool isRunning();
+    // Done part of the scan, percent
+    uint8_t getProgress();
+    // Channel to sample next
+    RFChannel getChannel();
+    void add(bool isBusy);
+    // Adds histogram measured by the peer
+    void merge(RFChannel first, const uint8_t *values, uint8_t count);
+    RFChannel getQuietest();
+    uint8_t getMaxHits(RFChannel first, uint8_t count);
+};
+
+#endif // LOWCOSTRC_RFSCAN_H
+// vim:ai:sw=2:et
@@ -0,0 +1,71 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_Stats.h>
+
+TimingStats::TimingStats() {
+  reset();
+}
+
+void TimingStats::reset() {
+  minValue = 0;
+  maxValue = 0;
+  sum = 0;
+  count = 0;
+  for (uint8_t i = 0; i < TIMING_STATS_BUCKETS; i++)
+    buckets[i] = 0;
+}
+
+void TimingStats::add(unsigned long value) {
+  uint8_t bucket = 0;
+  bool isFirst = count == 0;
+
+  // Halve the history instead of overflowing, so average and bucket
+  // shares stay meaningful and new values are still recorded
+  if (count == 0xffff || sum > 0xffffffffUL - value) {
+    sum >>= 1;
+    count >>= 1;
+    for (uint8_t i = 0; i < TIMING_STATS_BUCKETS; i++)
+      buckets[i] >>= 1;
+  }
+
+  if (isFirst || value < minValue) minValue = value;
+  if (value > maxValue) maxValue = value;
+  sum += value;
+  count++;
+
+  for (
+      value >>= TIMING_STATS_BUCKET_SHIFT;
+      value > 0 && bucket < TIMING_STATS_BUCKETS - 1;
+      value >>= 1
+  )
+    bucket++;
+  buckets[bucket]++;
+}
+
+unsigned long TimingStats::getAverage() {
+  return count > 0 ? sum / count : 0;
+}
+
+uint8_t TimingStats::getBucketShare(uint8_t bucket) {
+  return count > 0 ? (unsigned long)buckets[bucket] * 255 / count : 0;
+}
+
+void TimingStats::print(const __FlashStringHelper *name) {
+  PRINT(name);
+  PRINT(F(": n: "));
+  PRINT(count);
+  PRINT(F("; min: "));
+  PRINT(minValue);
+  PRINT(F("; avg: "));
+  PRINT(getAverage());
+  PRINT(F("; max: "));
+  PRINT(maxValue);
+  PRINT(F("; hist:"));
+  for (uint8_t i = 0; i < TIMING_STATS_BUCKETS; i++) {
+    PRINT(F(" "));
+    PRINT(buckets[i]);
+  }
+  PRINTLN();
+}
+
+// vim:ai:sw=2:et
@@ -0,0 +1,37 @@
+#ifndef LOWCOSTRC_STATS_H
+#define LOWCOSTRC_STATS_H
+
+#include <Arduino.h>
+
+// Histogram buckets: < 32us, < 64us, ... < 2048us, >= 2048us
+#define TIMING_STATS_BUCKETS 8
+#define TIMING_STATS_BUCKET_SHIFT 5
+
+class TimingStats {
+  public:
+    unsigned long minValue,
+                  maxValue,
+                  sum;
+    uint16_t count;
+    uint16_t buckets[TIMING_STATS_BUCKETS];
+
+    TimingStats();
+    void reset();
+    void add(unsigned long value);
+    unsigned long getAverage();
+    // Bucket share of all values, 0..255
+    uint8_t getBucketShare(uint8_t bucket);
+    void print(const __FlashStringHelper *name);
+};
+
+// Probes compile to nothing without WITH_TIMING_STATS
+#ifdef WITH_TIMING_STATS
+#define TIMING_START(var) unsigned long var = micros()
+#define TIMING_END(stats, var) (stats).add(micros() - (var))
+#else
+#define TIMING_START(var)
+#define TIMING_END(stats, var)
+#endif
+
+#endif // LOWCOSTRC_STATS_H
+// vim:ai:sw=2:et
@@ -5,11 +5,12 @@ class VoltMetter {
   private:
     int pin;
     unsigned long r1, r2;
-    unsigned long vHist[5] = {0, 0, 0, 0, 0};
-    byte vHistPos = 0;
+    int8_t slot;
 
   public:
     VoltMetter(int pin, unsigned long r1, unsigned long r2);
+    void begin();
+    // Returns latest value from ADC sampler, doesn't wait for conversion
     unsigned int readMillivolts();
 };
 
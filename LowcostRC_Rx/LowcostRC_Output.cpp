@@ -1,6 +1,11 @@
 #include <Arduino.h>
+#include <LowcostRC_Console.h>
 #include <LowcostRC_Output.h>
 
+// Fixed point scale used by throttle curve
+#define CURVE_BITS 12
+#define CURVE_ONE (1L << CURVE_BITS)
+
 void NullOutput::begin() {
 }
 
@@ -69,4 +74,269 @@ void BooleanOutput::write(uint16_t value) {
   digitalWrite(pin, (value >= minValue && value <= maxValue) ? HIGH : LOW);
 }
 
+void OutputPin::begin(int pin) {
+  pinMode(pin, OUTPUT);
+#ifdef ARDUINO_ARCH_AVR
+  port = portOutputRegister(digitalPinToPort(pin));
+  mask = digitalPinToBitMask(pin);
+#else
+  this->pin = pin;
+#endif
+}
+
+void OutputPin::write(bool value) {
+#ifdef ARDUINO_ARCH_AVR
+  uint8_t oldSREG = SREG;
+  cli();
+  if (value)
+    *port |= mask;
+  else
+    *port &= ~mask;
+  SREG = oldSREG;
+#else
+  digitalWrite(pin, value ? HIGH : LOW);
+#endif
+}
+
+#ifdef ARDUINO_ARCH_AVR
+DirectBooleanOutput::DirectBooleanOutput(int pin)
+  : BooleanOutput(pin)
+{
+}
+
+DirectBooleanOutput::DirectBooleanOutput(int pin, uint16_t minValue, uint16_t maxValue)
+  : BooleanOutput(pin, minValue, maxValue)
+{
+}
+
+void DirectBooleanOutput::begin() {
+  outputPin.begin(pin);
+  outputPin.write(false);
+}
+
+void DirectBooleanOutput::write(uint16_t value) {
+  outputPin.write(value >= minValue && value <= maxValue);
+}
+
+DirectPWMDutyCycleOutput::DirectPWMDutyCycleOutput(int pin)
+  : PWMDutyCycleOutput(pin)
+{
+}
+
+DirectPWMDutyCycleOutput::DirectPWMDutyCycleOutput(
+    int pin, uint16_t minValue, uint16_t maxValue
+) : PWMDutyCycleOutput(pin, minValue, maxValue)
+{
+}
+
+void DirectPWMDutyCycleOutput::begin() {
+  tccr = ocr8 = NULL;
+  ocr16 = NULL;
+  com = 0;
+
+  // Timers are already configured for PWM by Arduino core, we only need to
+  // know which registers to touch
+  switch (digitalPinToTimer(pin)) {
+#if defined(TCCR0A) && defined(COM0A1)
+    case TIMER0A:
+      tccr = &TCCR0A; ocr8 = &OCR0A; com = _BV(COM0A1);
+      break;
+#endif
+#if defined(TCCR0A) && defined(COM0B1)
+    case TIMER0B:
+      tccr = &TCCR0A; ocr8 = &OCR0B; com = _BV(COM0B1);
+      break;
+#endif
+#if defined(TCCR1A) && defined(COM1A1)
+    case TIMER1A:
+      tccr = &TCCR1A; ocr16 = &OCR1A; com = _BV(COM1A1);
+      break;
+#endif
+#if defined(TCCR1A) && defined(COM1B1)
+    case TIMER1B:
+      tccr = &TCCR1A; ocr16 = &OCR1B; com = _BV(COM1B1);
+      break;
+#endif
+#if defined(TCCR2A) && defined(COM2A1)
+    case TIMER2A:
+      tccr = &TCCR2A; ocr8 = &OCR2A; com = _BV(COM2A1);
+      break;
+#endif
+#if defined(TCCR2A) && defined(COM2B1)
+    case TIMER2B:
+      tccr = &TCCR2A; ocr8 = &OCR2B; com = _BV(COM2B1);
+      break;
+#endif
+  }
+
+  outputPin.begin(pin);
+  outputPin.write(false);
+}
+
+void DirectPWMDutyCycleOutput::write(uint16_t value) {
+  uint8_t duty;
+
+  value = constrain(value, minValue, maxValue);
+  duty = map(value, minValue, maxValue, 0, 255);
+
+  // Same as analogWrite(): 0 and 255 are driven as plain digital levels,
+  // pins without a timer are thresholded at 50%
+  if (tccr == NULL || duty == 0 || duty == 255) {
+    if (tccr != NULL)
+      *tccr &= ~com;
+    outputPin.write(duty >= 128);
+    return;
+  }
+
+  if (ocr16 != NULL)
+    *ocr16 = duty;
+  else
+    *ocr8 = duty;
+  *tccr |= com;
+}
+#endif
+
+PWMMotorOutput::PWMMotorOutput(int pin, unsigned long frequency, uint8_t expo)
+  : pin(pin),
+    minValue(1000),
+    maxValue(2000),
+    frequency(frequency)
+{
+  init(expo);
+}
+
+PWMMotorOutput::PWMMotorOutput(
+    int pin,
+    unsigned long frequency,
+    uint8_t expo,
+    uint16_t minValue,
+    uint16_t maxValue
+) : pin(pin),
+    minValue(minValue),
+    maxValue(maxValue),
+    frequency(frequency)
+{
+  init(expo);
+}
+
+void PWMMotorOutput::init(uint8_t expo) {
+  expo = constrain(expo, 0, 100);
+  // y = x * (1 - e) + x^3 * e, weights are in 1/256 units
+  cubicWeight = (uint16_t)expo * 256 / 100;
+  linearWeight = 256 - cubicWeight;
+  // (value - minValue) * scale >> 16 maps input range to 0..CURVE_ONE
+  scale = (CURVE_ONE << 16) / (maxValue - minValue);
+  range = 255;
+}
+
+void PWMMotorOutput::begin() {
+#ifdef ARDUINO_ARCH_AVR
+  unsigned long top;
+  uint8_t cs;
+
+  ocr8 = NULL;
+  ocr16 = NULL;
+
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+
+  switch (digitalPinToTimer(pin)) {
+#if defined(TCCR1A) && defined(ICR1)
+    case TIMER1A:
+    case TIMER1B:
+      // Phase correct PWM, TOP = ICR1; prescaler 1, 8, 64
+      top = F_CPU / 2 / frequency;
+      cs = _BV(CS10);
+      if (top > 0xffff) {
+        top /= 8;
+        cs = _BV(CS11);
+      }
+      if (top > 0xffff) {
+        top /= 8;
+        cs = _BV(CS11) | _BV(CS10);
+      }
+      range = constrain(top, 2, 0xffff);
+      TCCR1B = 0;
+      TCCR1A = _BV(WGM11);
+      ICR1 = range;
+      TCCR1B = _BV(WGM13) | cs;
+      if (digitalPinToTimer(pin) == TIMER1A) {
+        ocr16 = &OCR1A;
+        OCR1A = 0;
+        TCCR1A |= _BV(COM1A1);
+      } else {
+        ocr16 = &OCR1B;
+        OCR1B = 0;
+        TCCR1A |= _BV(COM1B1);
+      }
+      break;
+#endif
+#if defined(TCCR2A) && defined(COM2B1)
+    case TIMER2B:
+      // Phase correct PWM, TOP = OCR2A; prescaler 1, 8, 32
+      top = F_CPU / 2 / frequency;
+      cs = _BV(CS20);
+      if (top > 0xff) {
+        top /= 8;
+        cs = _BV(CS21);
+      }
+      if (top > 0xff) {
+        top /= 4;
+        cs = _BV(CS21) | _BV(CS20);
+      }
+      range = constrain(top, 2, 0xff);
+      TCCR2B = 0;
+      TCCR2A = _BV(WGM20);
+      OCR2A = range;
+      OCR2B = 0;
+      TCCR2B = _BV(WGM22) | cs;
+      TCCR2A |= _BV(COM2B1);
+      ocr8 = &OCR2B;
+      break;
+#endif
+    default:
+      PRINTLN(F("Motor: timer not supported, using default PWM"));
+      range = 255;
+  }
+#elif defined(ARDUINO_ARCH_ESP8266)
+  range = MOTOR_PWM_RANGE;
+  analogWriteFreq(frequency);
+  analogWriteRange(range);
+  pinMode(pin, OUTPUT);
+  analogWrite(pin, 0);
+#else
+  pinMode(pin, OUTPUT);
+  analogWrite(pin, 0);
+#endif
+  PRINT(F("Motor: PWM range: "));
+  PRINTLN(range);
+}
+
+void PWMMotorOutput::write(uint16_t value) {
+  unsigned long x, duty;
+
+  value = constrain(value, minValue, maxValue);
+  x = ((value - minValue) * scale) >> 16;
+  if (cubicWeight) {
+    unsigned long x3 = ((x * x) >> CURVE_BITS) * x >> CURVE_BITS;
+    x = (x * linearWeight + x3 * cubicWeight) >> 8;
+  }
+  duty = (x * range) >> CURVE_BITS;
+
+#ifdef ARDUINO_ARCH_AVR
+  if (ocr16 != NULL)
+    *ocr16 = duty;
+  else if (ocr8 != NULL)
+    *ocr8 = duty;
+  else
+    analogWrite(pin, duty);
+#else
+  analogWrite(pin, duty);
+#endif
+}
+
+uint16_t PWMMotorOutput::getRange() {
+  return range;
+}
+
 // vim:et:sw=2:ai
@@ -3,10 +3,22 @@
 
 #include <Servo.h>
 
+#ifndef MOTOR_PWM_FREQUENCY
+#define MOTOR_PWM_FREQUENCY 20000
+#endif
+
+#ifndef MOTOR_PWM_RANGE
+#define MOTOR_PWM_RANGE 1023
+#endif
+
 class BaseOutput {
   public:
     virtual void begin() = 0;
     virtual void write(uint16_t value) = 0;
+    // Called once all outputs are written for the received frame
+    virtual void flush() {};
+    // Called on every loop pass when no packet was received
+    virtual void handle() {};
 };
 
 class NullOutput : public BaseOutput {
@@ -26,7 +38,7 @@ class PWMMicrosecondsOutput : public BaseOutput {
 };
 
 class PWMDutyCycleOutput : public BaseOutput {
-  private:
+  protected:
     int pin;
     uint16_t minValue, maxValue;
   public:
@@ -37,7 +49,7 @@ class PWMDutyCycleOutput : public BaseOutput {
 };
 
 class BooleanOutput : public BaseOutput {
-  private:
+  protected:
     int pin;
     uint16_t minValue, maxValue;
   public:
@@ -47,5 +59,88 @@ class BooleanOutput : public BaseOutput {
     virtual void write(uint16_t value);
 };
 
+// Digital output pin with port register and bit mask resolved once in
+// begin(). Falls back to digitalWrite() on non AVR platforms.
+class OutputPin {
+  private:
+#ifdef ARDUINO_ARCH_AVR
+    volatile uint8_t *port;
+    uint8_t mask;
+#else
+    int pin;
+#endif
+  public:
+    void begin(int pin);
+    void write(bool value);
+};
+
+#ifdef ARDUINO_ARCH_AVR
+// Same as BooleanOutput, but writes port register directly
+class DirectBooleanOutput : public BooleanOutput {
+  private:
+    OutputPin outputPin;
+  public:
+    DirectBooleanOutput(int pin);
+    DirectBooleanOutput(int pin, uint16_t minValue, uint16_t maxValue);
+    virtual void begin();
+    virtual void write(uint16_t value);
+};
+
+// Same as PWMDutyCycleOutput, but writes timer compare register directly
+class DirectPWMDutyCycleOutput : public PWMDutyCycleOutput {
+  private:
+    OutputPin outputPin;
+    volatile uint8_t *tccr, *ocr8;
+    volatile uint16_t *ocr16;
+    uint8_t com;
+  public:
+    DirectPWMDutyCycleOutput(int pin);
+    DirectPWMDutyCycleOutput(int pin, uint16_t minValue, uint16_t maxValue);
+    virtual void begin();
+    virtual void write(uint16_t value);
+};
+#endif
+
+// PWM output for brushed motors with configurable frequency and optional expo
+// throttle curve (0..100%).
+//
+// On AVR timer is reprogrammed to phase correct PWM mode with variable TOP, so
+// resolution depends on frequency: F_CPU / (2 * frequency) steps, eg 200 steps
+// at 20kHz on 8MHz board. Supported pins are OC1A, OC1B (Timer1, conflicts
+// with Servo library) and OC2B (Timer2, pin 3 on ATmega328). On other pins
+// default Arduino PWM frequency is used.
+//
+// On ESP8266 analogWriteFreq() and analogWriteRange() are used. Note that these
+// settings are global for all PWM pins.
+class PWMMotorOutput : public BaseOutput {
+  private:
+    int pin;
+    uint16_t minValue, maxValue, range;
+    unsigned long frequency, scale;
+    uint16_t linearWeight, cubicWeight;
+#ifdef ARDUINO_ARCH_AVR
+    volatile uint8_t *ocr8;
+    volatile uint16_t *ocr16;
+#endif
+
+    void init(uint8_t expo);
+  public:
+    PWMMotorOutput(
+        int pin,
+        unsigned long frequency = MOTOR_PWM_FREQUENCY,
+        uint8_t expo = 0
+    );
+    PWMMotorOutput(
+        int pin,
+        unsigned long frequency,
+        uint8_t expo,
+        uint16_t minValue,
+        uint16_t maxValue
+    );
+    virtual void begin();
+    virtual void write(uint16_t value);
+    uint16_t getRange();
+};
+
 #endif // LOWCOSTRC_OUTPUT_H
 // vim:et:sw=2:ai
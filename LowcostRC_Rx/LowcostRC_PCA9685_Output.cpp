@@ -0,0 +1,190 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_PCA9685_Output.h>
+
+#define PCA9685_MODE1 0x00
+#define PCA9685_MODE2 0x01
+#define PCA9685_LED0_ON_L 0x06
+#define PCA9685_PRESCALE 0xfe
+
+#define MODE1_RESTART 0x80
+#define MODE1_AI 0x20
+#define MODE1_SLEEP 0x10
+#define MODE2_OUTDRV 0x04
+
+#define PCA9685_OSC_FREQUENCY 25000000L
+#define PCA9685_FULL 0x1000
+
+#ifndef BUFFER_LENGTH
+#define BUFFER_LENGTH 32
+#endif
+
+// Register address byte plus 4 bytes per channel must fit Wire buffer
+#define PCA9685_BURST_CHANNELS ((BUFFER_LENGTH - 1) / 4)
+
+PCA9685::PCA9685(uint8_t address, uint16_t frequency)
+  : address(address),
+    frequency(frequency),
+    dirty(0),
+    attached(0),
+    isStarted(false)
+{
+  for (uint8_t i = 0; i < PCA9685_NUM_CHANNELS; i++) {
+    on[i] = 0;
+    off[i] = PCA9685_FULL;
+  }
+}
+
+void PCA9685::writeRegister(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
+}
+
+bool PCA9685::begin() {
+  uint8_t prescale;
+
+  if (isStarted) return true;
+
+  Wire.begin();
+  Wire.setClock(400000L);
+
+  Wire.beginTransmission(address);
+  if (Wire.endTransmission() != 0) {
+    PRINTLN(F("PCA9685: init: FAIL"));
+    return false;
+  }
+
+  prescale = constrain(
+    (PCA9685_OSC_FREQUENCY + 2048L * frequency) / (4096L * frequency) - 1,
+    3,
+    255
+  );
+
+  writeRegister(PCA9685_MODE1, MODE1_SLEEP | MODE1_AI);
+  writeRegister(PCA9685_PRESCALE, prescale);
+  writeRegister(PCA9685_MODE2, MODE2_OUTDRV);
+  writeRegister(PCA9685_MODE1, MODE1_AI);
+  delayMicroseconds(500); // Wait for oscillator
+  writeRegister(PCA9685_MODE1, MODE1_AI | MODE1_RESTART);
+
+  dirty = 0xffff;
+  isStarted = true;
+  PRINTLN(F("PCA9685: init: OK"));
+  return true;
+}
+
+bool PCA9685::attach(uint8_t channel) {
+  bool isFirst = attached == 0;
+  bitSet(attached, channel);
+  return isFirst;
+}
+
+uint16_t PCA9685::getFrequency() {
+  return frequency;
+}
+
+void PCA9685::setCount(uint8_t channel, uint16_t count) {
+  uint16_t newOn, newOff;
+
+  if (count == 0) {
+    newOn = 0;
+    newOff = PCA9685_FULL;
+  } else if (count >= 4096) {
+    newOn = PCA9685_FULL;
+    newOff = 0;
+  } else {
+    newOn = 0;
+    newOff = count;
+  }
+
+  if (newOn != on[channel] || newOff != off[channel]) {
+    on[channel] = newOn;
+    off[channel] = newOff;
+    bitSet(dirty, channel);
+  }
+}
+
+void PCA9685::handle() {
+  uint8_t first, last;
+
+  if (!isStarted || dirty == 0) return;
+
+  for (first = 0; !bitRead(dirty, first); first++);
+  for (
+    last = first;
+    last + 1 < PCA9685_NUM_CHANNELS && last + 1 - first < PCA9685_BURST_CHANNELS;
+    last++
+  );
+  while (!bitRead(dirty, last)) last--;
+
+  Wire.beginTransmission(address);
+  Wire.write(PCA9685_LED0_ON_L + 4 * first);
+  for (uint8_t i = first; i <= last; i++) {
+    Wire.write(on[i] & 0xff);
+    Wire.write(on[i] >> 8);
+    Wire.write(off[i] & 0xff);
+    Wire.write(off[i] >> 8);
+    bitClear(dirty, i);
+  }
+  Wire.endTransmission();
+}
+
+PCA9685Output::PCA9685Output(PCA9685 *chip, uint8_t channel)
+  : chip(chip),
+    channel(channel),
+    isLeader(false)
+{
+}
+
+void PCA9685Output::begin() {
+  chip->begin();
+  // The first attached output flushes the chip, so there is at most one I2C
+  // burst per loop pass
+  isLeader = chip->attach(channel);
+}
+
+void PCA9685Output::handle() {
+  if (isLeader) chip->handle();
+}
+
+PCA9685MicrosecondsOutput::PCA9685MicrosecondsOutput(PCA9685 *chip, uint8_t channel)
+  : PCA9685Output(chip, channel)
+{
+}
+
+void PCA9685MicrosecondsOutput::begin() {
+  PCA9685Output::begin();
+  // count = us * frequency * 4096 / 1000000, 16 bit fixed point:
+  // frequency * 2^22 / 15625, split so that it fits 32 bits
+  unsigned long frequency = chip->getFrequency();
+  scale = frequency * (4194304UL / 15625UL)
+    + frequency * (4194304UL % 15625UL) / 15625UL;
+}
+
+void PCA9685MicrosecondsOutput::write(uint16_t value) {
+  chip->setCount(channel, ((unsigned long)value * scale) >> 16);
+}
+
+PCA9685DutyCycleOutput::PCA9685DutyCycleOutput(PCA9685 *chip, uint8_t channel)
+  : PCA9685Output(chip, channel),
+    minValue(1000),
+    maxValue(2000)
+{
+}
+
+PCA9685DutyCycleOutput::PCA9685DutyCycleOutput(
+    PCA9685 *chip, uint8_t channel, uint16_t minValue, uint16_t maxValue
+) : PCA9685Output(chip, channel),
+    minValue(minValue),
+    maxValue(maxValue)
+{
+}
+
+void PCA9685DutyCycleOutput::write(uint16_t value) {
+  value = constrain(value, minValue, maxValue);
+  chip->setCount(channel, map(value, minValue, maxValue, 0, 4096));
+}
+
+// vim:et:sw=2:ai
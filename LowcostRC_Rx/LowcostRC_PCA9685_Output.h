@@ -0,0 +1,67 @@
+#ifndef LOWCOSTRC_PCA9685_OUTPUT_H
+#define LOWCOSTRC_PCA9685_OUTPUT_H
+
+#include <Wire.h>
+#include <LowcostRC_Output.h>
+
+#define PCA9685_DEFAULT_ADDRESS 0x40
+#define PCA9685_NUM_CHANNELS 16
+
+// PCA9685 16 channel PWM chip. Outputs only update channel buffer, dirty
+// channels are sent with auto-increment burst writes from handle(), one
+// burst per call.
+class PCA9685 {
+  private:
+    uint8_t address;
+    uint16_t frequency,
+             dirty,
+             attached;
+    uint16_t on[PCA9685_NUM_CHANNELS],
+             off[PCA9685_NUM_CHANNELS];
+    bool isStarted;
+
+    void writeRegister(uint8_t reg, uint8_t value);
+  public:
+    PCA9685(uint8_t address = PCA9685_DEFAULT_ADDRESS, uint16_t frequency = 50);
+    bool begin();
+    bool attach(uint8_t channel);
+    uint16_t getFrequency();
+    void setCount(uint8_t channel, uint16_t count);
+    void handle();
+};
+
+class PCA9685Output : public BaseOutput {
+  protected:
+    PCA9685 *chip;
+    uint8_t channel;
+    bool isLeader;
+  public:
+    PCA9685Output(PCA9685 *chip, uint8_t channel);
+    virtual void begin();
+    virtual void handle();
+};
+
+// Takes impulse width in microseconds like PWMMicrosecondsOutput
+class PCA9685MicrosecondsOutput : public PCA9685Output {
+  private:
+    unsigned long scale;
+  public:
+    PCA9685MicrosecondsOutput(PCA9685 *chip, uint8_t channel);
+    virtual void begin();
+    virtual void write(uint16_t value);
+};
+
+// Takes 0..100% duty cycle range like PWMDutyCycleOutput
+class PCA9685DutyCycleOutput : public PCA9685Output {
+  private:
+    uint16_t minValue, maxValue;
+  public:
+    PCA9685DutyCycleOutput(PCA9685 *chip, uint8_t channel);
+    PCA9685DutyCycleOutput(
+        PCA9685 *chip, uint8_t channel, uint16_t minValue, uint16_t maxValue
+    );
+    virtual void write(uint16_t value);
+};
+
+#endif // LOWCOSTRC_PCA9685_OUTPUT_H
+// vim:et:sw=2:ai
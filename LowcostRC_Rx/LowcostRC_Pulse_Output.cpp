@@ -0,0 +1,188 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_Pulse_Output.h>
+
+#ifdef ARDUINO_ARCH_AVR
+
+// Timer1 runs with prescaler 8
+#define TICKS_PER_US (F_CPU / 8000000L)
+// Events closer than this can't be set up on the compare unit in time,
+// the interrupt waits for them instead. Pulses never end early.
+#define MARGIN_TICKS (4 * TICKS_PER_US)
+// Longest compare distance, interrupt wakes up for re-scheduling at least
+// that often
+#define MAX_WAIT_TICKS 30000
+
+struct PulseChannel {
+  OutputPin pin;
+  uint16_t width,        // pulse width, ticks
+           period,       // frame period, ticks
+           minInterval,  // minimal interval between pulses starts, ticks
+           start,        // last pulse start time, ticks
+           end;          // current pulse end time, ticks
+  bool isActive;
+};
+
+static const struct {
+  uint16_t period, minInterval;
+  uint8_t divider;
+} pulseModes[] = {
+  // PULSE_MODE_SERVO_50HZ
+  {20000 * TICKS_PER_US, 20000 * TICKS_PER_US, 1},
+  // PULSE_MODE_SERVO_333HZ
+  {3000 * TICKS_PER_US, 3000 * TICKS_PER_US, 1},
+  // PULSE_MODE_ONESHOT125
+  {2000 * TICKS_PER_US, 500 * TICKS_PER_US, 8},
+  // PULSE_MODE_ONESHOT42
+  {1000 * TICKS_PER_US, 200 * TICKS_PER_US, 24},
+};
+
+static PulseChannel channels[MAX_PULSE_OUTPUTS];
+static uint8_t numChannels = 0;
+static volatile bool isBusy = false,
+                     isTriggered = false;
+
+static void startPulses(uint16_t now, bool trigger) {
+  PulseChannel *ch;
+  uint16_t elapsed;
+
+  for (uint8_t i = 0; i < numChannels; i++) {
+    ch = &channels[i];
+    if (ch->width == 0) continue;
+    elapsed = now - ch->start;
+    if (elapsed >= ch->period || (trigger && elapsed >= ch->minInterval)) {
+      ch->pin.write(true);
+      ch->start = now;
+      ch->end = now + ch->width;
+      ch->isActive = true;
+      isBusy = true;
+    }
+  }
+}
+
+// Must be called with interrupts disabled
+static void schedule() {
+  PulseChannel *ch;
+  uint16_t now, next, wait;
+
+  for (;;) {
+    now = TCNT1;
+
+    // End pulses
+    isBusy = false;
+    for (uint8_t i = 0; i < numChannels; i++) {
+      ch = &channels[i];
+      if (!ch->isActive) continue;
+      if ((int16_t)(ch->end - now) <= 0) {
+        ch->pin.write(false);
+        ch->isActive = false;
+      } else {
+        isBusy = true;
+      }
+    }
+
+    // Start new pulses when nothing is running, so all pulses started
+    // together end in order
+    if (!isBusy) {
+      startPulses(now, isTriggered);
+      isTriggered = false;
+    }
+
+    // Find nearest event
+    wait = MAX_WAIT_TICKS;
+    for (uint8_t i = 0; i < numChannels; i++) {
+      ch = &channels[i];
+      if (isBusy) {
+        if (ch->isActive && (uint16_t)(ch->end - now) < wait)
+          wait = ch->end - now;
+      } else if (ch->width != 0) {
+        if ((uint16_t)(ch->start + ch->period - now) < wait)
+          wait = ch->start + ch->period - now;
+      }
+    }
+
+    next = now + wait;
+    if ((int16_t)(next - TCNT1) > (int16_t)MARGIN_TICKS) {
+      OCR1B = next;
+      break;
+    }
+    while ((int16_t)(next - TCNT1) > 0);
+  }
+}
+
+// Pulses are started and ended only by the compare interrupt, so a
+// trigger between pulses just moves it close
+static void triggerPulses() {
+  uint8_t oldSREG = SREG;
+  cli();
+  isTriggered = true;
+  if (!isBusy)
+    OCR1B = TCNT1 + MARGIN_TICKS;
+  SREG = oldSREG;
+}
+
+ISR(TIMER1_COMPB_vect) {
+  schedule();
+}
+
+PulseOutput::PulseOutput(int pin, PulseMode mode)
+  : pin(pin),
+    mode(mode),
+    index(-1)
+{
+}
+
+void PulseOutput::begin() {
+  uint8_t oldSREG;
+
+  if (numChannels >= MAX_PULSE_OUTPUTS) {
+    PRINTLN(F("Pulse: Error: too many outputs"));
+    return;
+  }
+
+  oldSREG = SREG;
+  cli();
+
+  if (numChannels == 0) {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11);
+    OCR1B = TCNT1 + MAX_WAIT_TICKS;
+    TIFR1 = _BV(OCF1B);
+    TIMSK1 |= _BV(OCIE1B);
+  }
+
+  index = numChannels++;
+  channels[index].pin.begin(pin);
+  channels[index].pin.write(false);
+  channels[index].width = 0;
+  channels[index].period = pulseModes[mode].period;
+  channels[index].minInterval = pulseModes[mode].minInterval;
+  channels[index].start = TCNT1 - channels[index].period;
+  channels[index].isActive = false;
+
+  SREG = oldSREG;
+}
+
+void PulseOutput::write(uint16_t value) {
+  uint16_t width;
+  uint8_t oldSREG;
+
+  if (index < 0) return;
+
+  value = constrain(value, 500, 2500);
+  width = (uint32_t)value * TICKS_PER_US / pulseModes[mode].divider;
+
+  oldSREG = SREG;
+  cli();
+  channels[index].width = width;
+  SREG = oldSREG;
+}
+
+void PulseOutput::flush() {
+  if (index < 0) return;
+  triggerPulses();
+}
+
+#endif // ARDUINO_ARCH_AVR
+
+// vim:et:sw=2:ai
@@ -0,0 +1,41 @@
+#ifndef LOWCOSTRC_PULSE_OUTPUT_H
+#define LOWCOSTRC_PULSE_OUTPUT_H
+
+#include <LowcostRC_Output.h>
+
+#ifdef ARDUINO_ARCH_AVR
+
+#define MAX_PULSE_OUTPUTS 8
+
+enum PulseModeEnum {
+  PULSE_MODE_SERVO_50HZ,   // Analog servo, 20ms frame
+  PULSE_MODE_SERVO_333HZ,  // Digital servo, 3ms frame
+  PULSE_MODE_ONESHOT125,   // ESC, 125..250us pulse
+  PULSE_MODE_ONESHOT42,    // ESC, 42..84us pulse
+};
+
+typedef uint8_t PulseMode;
+
+// Pulse output driven by Timer1 compare B interrupt. Unlike Servo library,
+// pulses are started right after control frame is received (as soon as
+// minimal pulse interval allows) and repeated with the mode frame period when
+// no new frames arrive.
+//
+// Timer1 is shared with Servo library and PWMMotorOutput on OC1A/OC1B pins,
+// so don't use them in the same sketch.
+class PulseOutput : public BaseOutput {
+  private:
+    int pin;
+    PulseMode mode;
+    int8_t index;
+  public:
+    PulseOutput(int pin, PulseMode mode);
+    virtual void begin();
+    virtual void write(uint16_t value);
+    virtual void flush();
+};
+
+#endif // ARDUINO_ARCH_AVR
+
+#endif // LOWCOSTRC_PULSE_OUTPUT_H
+// vim:et:sw=2:ai
@@ -0,0 +1,54 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_Rx.h>
+
+BaseReceiver::BaseReceiver()
+  : pairState(RX_PAIR_STATE_IDLE),
+    pairStartTime(0)
+{
+}
+
+void BaseReceiver::startPairing() {
+  PRINTLN(F("Starting pairing"));
+  pairState = RX_PAIR_STATE_PAIRING;
+  pairStartTime = millis();
+  enterPairing();
+}
+
+RxPairState BaseReceiver::handlePairing() {
+  RequestPacket req;
+
+  if (pairState != RX_PAIR_STATE_PAIRING)
+    return pairState;
+
+  if (millis() - pairStartTime > PAIR_TIMEOUT) {
+    PRINTLN(F("Not paired"));
+    leavePairing(false);
+    return pairState = RX_PAIR_STATE_FAILED;
+  }
+
+  if (!receive(&req))
+    return pairState;
+
+  if (req.pair.packetType != PACKET_TYPE_PAIR) {
+    PRINTLN(F("Ignoring non-pair type packet"));
+    return pairState;
+  }
+
+  // Transmitter repeats INIT until READY arrives, answer every copy
+  if (req.pair.status == PAIR_STATUS_INIT) {
+    sendPairReady(&req.pair);
+  } else if (req.pair.status == PAIR_STATUS_PAIRED) {
+    PRINTLN(F("Paired"));
+    leavePairing(true);
+    pairState = RX_PAIR_STATE_PAIRED;
+  }
+
+  return pairState;
+}
+
+bool BaseReceiver::isPairing() {
+  return pairState == RX_PAIR_STATE_PAIRING;
+}
+
+// vim:et:sw=2:ai
@@ -3,8 +3,28 @@
 
 #include <LowcostRC_Protocol.h>
 
+#define PAIR_TIMEOUT 10000
+
+enum RxPairStateEnum {
+  RX_PAIR_STATE_IDLE,
+  RX_PAIR_STATE_PAIRING,
+  RX_PAIR_STATE_PAIRED,
+  RX_PAIR_STATE_FAILED,
+};
+
+typedef uint8_t RxPairState;
+
 class BaseReceiver {
+  protected:
+    RxPairState pairState;
+    unsigned long pairStartTime;
+
+    // Pairing hooks, called by handlePairing()
+    virtual void enterPairing() {};
+    virtual void sendPairReady(const PairPacket *request) {};
+    virtual void leavePairing(bool isPaired) {};
   public:
+    BaseReceiver();
     virtual bool begin(const Address *address, RFChannel channel, PALevel level) = 0;
     virtual const Address *getAddress() = 0;     // receiver device (Rx) address
     virtual const Address *getPeerAddress() = 0; // remote device (Tx) address
@@ -13,8 +33,19 @@ class BaseReceiver {
     virtual void setPALevel(PALevel level) = 0;
     virtual bool receive(RequestPacket *packet) = 0;
     virtual void send(const ResponsePacket *packet) = 0;
-    virtual bool pair() = 0;
     virtual bool isPaired() = 0;
+    // Pairing is stepped by handlePairing() on every loop pass until it
+    // returns RX_PAIR_STATE_PAIRED or RX_PAIR_STATE_FAILED. Each step
+    // handles at most one received packet and never waits.
+    virtual void startPairing();
+    virtual RxPairState handlePairing();
+    bool isPairing();
+    // micros() when the last received packet arrived, 0 if unknown. Polled
+    // radios like nRF24 only see the packet when it is read.
+    virtual unsigned long getPacketTime() { return 0; };
+    // Carrier detection for RF scan, radio returns to the link channel
+    virtual bool canScanRF() { return false; };
+    virtual bool isChannelBusy(RFChannel ch) { return false; };
 };
 
 #endif // LOWCOSTRC_RX_H
@@ -7,10 +7,29 @@
 #define TELEMETRY_INTERVAL 5000
 #endif
 
+// Upper bound for full failsafe timeout
 #ifndef FAILSAFE_TIMEOUT
 #define FAILSAFE_TIMEOUT 1250
 #endif
 
+// Missing frames before hold and full failsafe stages
+#ifndef FAILSAFE_HOLD_FRAMES
+#define FAILSAFE_HOLD_FRAMES 4
+#endif
+
+#ifndef FAILSAFE_FULL_FRAMES
+#define FAILSAFE_FULL_FRAMES 20
+#endif
+
+#ifndef FAILSAFE_RAMP_RATE
+#define FAILSAFE_RAMP_RATE 250
+#endif
+
+#define FAILSAFE_RAMP_STEP 20
+
+// Frame interval is kept in 1/16 ms
+#define FRAME_INTERVAL_SHIFT 4
+
 RxController::RxController(
     BaseRxSettings *settings,
     BaseReceiver *receiver,
@@ -32,6 +51,18 @@ RxController::RxController(
     this->outputs[i] = NULL;
 
   isLedInverted = false;
+  packetTime = 0;
+  mixerDefaults = NULL;
+  stabilizer = NULL;
+#ifdef WITH_TIMING_STATS
+  timingStatsProbe = 0;
+#endif
+#ifdef WITH_RF_SCAN
+  rfScanReportChannel = RF_SCAN_CHANNELS;
+#endif
+  failsafeRampRate = FAILSAFE_RAMP_RATE;
+  for (i = 0; i < NUM_CHANNELS; i++)
+    failsafeModes[i] = FAILSAFE_MODE_VALUE;
 }
 
 bool RxController::begin() {
@@ -41,25 +72,37 @@ bool RxController::begin() {
     pinMode(pairPin, INPUT_PULLUP);
 
   if (ledPin >= 0) {
-    pinMode(ledPin, OUTPUT);
-    digitalWrite(ledPin, (isLedInverted) ? HIGH : LOW);
+    led.begin(ledPin);
+    writeLed(false);
   }
 
   for (int i = 0; i < NUM_CHANNELS; i++)
     if ((output = outputs[i]) != NULL)
       output->begin();
 
+  if (voltMetter != NULL)
+    voltMetter->begin();
+  sensors.begin();
+  nextSensor = 0;
+
+  if (stabilizer != NULL)
+    stabilizer->begin();
+
   if (!settings->begin())
     return false;
 
   if (!settings->load()) {
     PRINTLN(F("No stored settings found, use defaults"));
     settings->setDefaults();
+    if (mixerDefaults != NULL)
+      memcpy_P(&settings->values.mixer, mixerDefaults, sizeof(RxMixerSettings));
     settings->save();
   } else {
     PRINTLN(F("Using stored settings"));
   }
 
+  updateMixer();
+
   if (
       !receiver->begin(
         &settings->values.address, settings->values.rfChannel, settings->values.paLevel
@@ -68,9 +111,13 @@ bool RxController::begin() {
     return false;
 
   hasLastChannels = false;
+  responseHead = 0;
+  responseCount = 0;
   controlTime = 0;
   telemetryTime = 0;
   isFailsafe = false;
+  failsafeStage = FAILSAFE_STAGE_NONE;
+  frameInterval = CONTROL_PING_INTERVAL << FRAME_INTERVAL_SHIFT;
 
   return true;
 }
@@ -78,55 +125,132 @@ bool RxController::begin() {
 void RxController::handle() {
   unsigned long now;
   union RequestPacket rp;
+  ControlPacket control;
+  const uint16_t *channels;
+  bool isReceived;
 
-  if (receiver->receive(&rp)) {
-    if (ledPin >= 0) 
-      digitalWrite(ledPin, (isLedInverted) ? LOW : HIGH);
+  TIMING_START(loopStart);
 
-    handlePacket(&rp);
+  // Stabilizer ticks at fixed rate, outputs are updated on every tick
+  if (stabilizer != NULL && hasLastChannels) {
+    channels = failsafeStage == FAILSAFE_STAGE_FULL ? failsafeChannels : lastChannels;
+    if (stabilizer->handle(channels)) {
+      control.packetType = PACKET_TYPE_CONTROL;
+      for (int i = 0; i < NUM_CHANNELS; i++)
+        control.channels[i] = channels[i];
+      processControl(&control);
+    }
+  }
 
-    if (ledPin >= 0) 
-      digitalWrite(ledPin, (isLedInverted) ? HIGH : LOW);
+  TIMING_START(receiveStart);
+  // While pairing, packets are consumed by the pairing step
+  isReceived = !receiver->isPairing() && receiver->receive(&rp);
+  if (isReceived) {
+    packetTime = receiver->getPacketTime();
+    if (packetTime == 0) packetTime = micros();
+    TIMING_END(timingStats[TIMING_PROBE_RECEIVE], receiveStart);
+    writeLed(true);
+    TIMING_START(handleStart);
+    handlePacket(&rp);
+    TIMING_END(timingStats[TIMING_PROBE_HANDLE_PACKET], handleStart);
+#ifdef WITH_TIMING_STATS
+    if (rp.generic.packetType == PACKET_TYPE_CONTROL)
+      timingStats[TIMING_PROBE_LATENCY].add(micros() - packetTime);
+#endif
+    // Every received frame frees an ack payload slot on nRF24
+#ifdef WITH_RF_SCAN
+    if (!sendQueuedResponse() && rfScanReportChannel < RF_SCAN_CHANNELS)
+      reportRFScan();
+#else
+    sendQueuedResponse();
+#endif
+    writeLed(false);
+  } else {
+    for (int i = 0; i < NUM_CHANNELS; i++)
+      if (outputs[i] != NULL)
+        outputs[i]->handle();
+    settings->handle();
+#ifdef WITH_RF_SCAN
+    // One channel per idle pass, the link channel is left only briefly
+    if (rfScan.isRunning()) {
+      rfScan.add(receiver->isChannelBusy(rfScan.getChannel()));
+      if (!rfScan.isRunning()) {
+        PRINTLN(F("RF scan done"));
+        rfScanReportChannel = 0;
+      }
+    }
+#endif
   }
 
+  // Sensors only run on idle passes, so they never delay control frames
+  sensors.handle(!isReceived);
+
   now = millis();
 
-  if (now - telemetryTime > TELEMETRY_INTERVAL) {
+  if (now - telemetryTime > TELEMETRY_INTERVAL && !receiver->isPairing()) {
     sendTelemetry();
+#ifdef WITH_TIMING_STATS
+    reportTimingStats();
+#endif
+#ifdef WITH_CONSOLE
+    if (stabilizer != NULL)
+      stabilizer->printStats();
+#endif
     telemetryTime = now;
   }
 
-  if (!isFailsafe && controlTime > 0 && now - controlTime > FAILSAFE_TIMEOUT) {
-    PRINTLN(F("Radio signal lost"));
-    isFailsafe = true;
+  if (controlTime > 0)
+    handleFailsafe(now);
 
-    applyControl(&settings->values.failsafe);
-  }
+  TIMING_END(timingStats[TIMING_PROBE_LOOP], loopStart);
 
-  if (
-      (pairPin >= 0 && digitalRead(pairPin) == LOW)
-      || (pairPin < 0 && !receiver->isPaired())
-  ) {
-    if (receiver->pair()) {
+  if (receiver->isPairing()) {
+    if (receiver->handlePairing() == RX_PAIR_STATE_PAIRED) {
       memcpy(
           settings->values.address.address,
           receiver->getPeerAddress()->address,
           ADDRESS_LENGTH
       );
+      settings->values.rfChannel = receiver->getRFChannel();
       settings->save();
     }
+  } else if (
+      (pairPin >= 0 && digitalRead(pairPin) == LOW)
+      || (pairPin < 0 && !receiver->isPaired())
+  ) {
+    receiver->startPairing();
   }
 }
 
 void RxController::handlePacket(const RequestPacket *rp) {
   ControlPacket *failsafe;
+  ResponsePacket resp;
+  unsigned long now, sample;
 
   if (rp->generic.packetType == PACKET_TYPE_CONTROL) {
-    controlTime = millis();
+    now = millis();
+
+    // Learn frame cadence. Gaps are capped by transmitter ping interval,
+    // since idle sticks are only reported that often.
+    if (controlTime > 0 && failsafeStage == FAILSAFE_STAGE_NONE) {
+      sample = min(now - controlTime, (unsigned long)CONTROL_PING_INTERVAL);
+      frameInterval = (
+        frameInterval - (frameInterval >> 3)
+        + (sample << (FRAME_INTERVAL_SHIFT - 3))
+      );
+    }
+
+    if (failsafeStage != FAILSAFE_STAGE_NONE)
+      PRINTLN(F("Radio signal restored"));
+
+    controlTime = now;
     isFailsafe = false;
+    failsafeStage = FAILSAFE_STAGE_NONE;
 
     for (int i = 0; i < NUM_CHANNELS; i++)
       lastChannels[i] = rp->control.channels[i];
+    if (!hasLastChannels && stabilizer != NULL)
+      stabilizer->reset();
     hasLastChannels = true;
 
 #ifdef WITH_CONSOLE
@@ -143,7 +267,7 @@ void RxController::handlePacket(const RequestPacket *rp) {
     }
 #endif
 
-    applyControl(&rp->control);
+    processControl(&rp->control);
   } else if (rp->generic.packetType == PACKET_TYPE_SET_RF_CHANNEL) {
     PRINT(F("New RF channel: "));
     PRINTLN(rp->rfChannel.rfChannel);
@@ -156,6 +280,12 @@ void RxController::handlePacket(const RequestPacket *rp) {
     receiver->setPALevel(rp->paLevel.paLevel);
     settings->values.paLevel = rp->paLevel.paLevel;
     settings->save();
+  } else if (rp->generic.packetType == PACKET_TYPE_PING) {
+    // Transmitter works out round trip time and clock offset
+    resp.pong.packetType = PACKET_TYPE_PONG;
+    resp.pong.txTime = rp->ping.txTime;
+    resp.pong.rxTime = packetTime;
+    queueResponse(&resp);
   } else if (rp->generic.packetType == PACKET_TYPE_COMMAND) {
     if (rp->command.command == COMMAND_SAVE_FAILSAFE && hasLastChannels) {
       PRINT(F("Saving state for failsafe"));
@@ -165,18 +295,118 @@ void RxController::handlePacket(const RequestPacket *rp) {
         failsafe->channels[i] = lastChannels[i];
       settings->save();
     }
+#ifdef WITH_RF_SCAN
+    else if (rp->command.command == COMMAND_SCAN_RF && receiver->canScanRF()) {
+      PRINTLN(F("RF scan started"));
+      rfScan.start();
+      rfScanReportChannel = RF_SCAN_CHANNELS;
+    }
+#endif
+  }
+}
+
+void RxController::processControl(const ControlPacket *control) {
+  ControlPacket stabilized, mixed;
+
+  TIMING_START(applyStart);
+  if (stabilizer != NULL) {
+    memcpy(&stabilized, control, sizeof(ControlPacket));
+    stabilizer->apply(&stabilized);
+    control = &stabilized;
   }
+  mixer.apply(control, &mixed);
+  applyControl(&mixed);
+  TIMING_END(timingStats[TIMING_PROBE_APPLY], applyStart);
 }
 
 void RxController::applyControl(const ControlPacket *control) {
   for (int i = 0; i < NUM_CHANNELS; i++)
     if (outputs[i] != NULL)
       outputs[i]->write(control->channels[i]);
+  for (int i = 0; i < NUM_CHANNELS; i++)
+    if (outputs[i] != NULL)
+      outputs[i]->flush();
+}
+
+void RxController::handleFailsafe(unsigned long now) {
+  unsigned long elapsed = now - controlTime,
+                interval = frameInterval >> FRAME_INTERVAL_SHIFT,
+                holdTimeout,
+                fullTimeout;
+
+  if (failsafeStage == FAILSAFE_STAGE_FULL) {
+    if (now - failsafeTime >= FAILSAFE_RAMP_STEP) {
+      applyFailsafe(now - failsafeTime);
+      failsafeTime = now;
+    }
+    return;
+  }
+
+  holdTimeout = max(
+    FAILSAFE_HOLD_FRAMES * interval,
+    (unsigned long)CONTROL_PING_INTERVAL + CONTROL_PING_INTERVAL / 4
+  );
+  fullTimeout = constrain(
+    FAILSAFE_FULL_FRAMES * interval,
+    3UL * CONTROL_PING_INTERVAL,
+    (unsigned long)FAILSAFE_TIMEOUT
+  );
+
+  if (failsafeStage == FAILSAFE_STAGE_NONE && elapsed > holdTimeout) {
+    PRINTLN(F("Radio signal lost, holding"));
+    failsafeStage = FAILSAFE_STAGE_HOLD;
+  }
+
+  if (failsafeStage == FAILSAFE_STAGE_HOLD && elapsed > fullTimeout) {
+    PRINTLN(F("Radio signal lost"));
+    failsafeStage = FAILSAFE_STAGE_FULL;
+    isFailsafe = true;
+    failsafeTime = now;
+
+    for (int i = 0; i < NUM_CHANNELS; i++)
+      failsafeChannels[i] = lastChannels[i];
+    applyFailsafe(0);
+  }
+}
+
+void RxController::applyFailsafe(unsigned long elapsed) {
+  ControlPacket control;
+  uint16_t target, step;
+  bool isChanged = elapsed == 0;
+
+  step = max(1UL, failsafeRampRate * elapsed / 1000);
+
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    target = settings->values.failsafe.channels[i];
+
+    switch (failsafeModes[i]) {
+      case FAILSAFE_MODE_VALUE:
+        failsafeChannels[i] = target;
+        break;
+      case FAILSAFE_MODE_RAMP:
+        if (failsafeChannels[i] < target) {
+          failsafeChannels[i] = min(failsafeChannels[i] + step, (int)target);
+          isChanged = true;
+        } else if (failsafeChannels[i] > target) {
+          failsafeChannels[i] = max(failsafeChannels[i] - step, (int)target);
+          isChanged = true;
+        }
+        break;
+    }
+  }
+
+  if (!isChanged) return;
+
+  control.packetType = PACKET_TYPE_CONTROL;
+  for (int i = 0; i < NUM_CHANNELS; i++)
+    control.channels[i] = failsafeChannels[i];
+  processControl(&control);
 }
 
 void RxController::sendTelemetry() {
   unsigned int batteryMV;
   ResponsePacket resp;
+  BaseSensor *sensor;
 
   resp.telemetry.packetType = PACKET_TYPE_TELEMETRY;
 
@@ -189,11 +419,139 @@ void RxController::sendTelemetry() {
   PRINTLN(batteryMV);
   resp.telemetry.batteryMV = batteryMV;
 
+  queueResponse(&resp);
+
+  if (sensors.getCount() == 0) return;
+
+  // Values of up to SENSORS_PACKET_VALUES sensors, in turn
+  resp.sensors.packetType = PACKET_TYPE_SENSORS;
+  for (uint8_t i = 0; i < SENSORS_PACKET_VALUES; i++) {
+    if (i < sensors.getCount()) {
+      sensor = sensors.get(nextSensor);
+      resp.sensors.values[i].type = sensor->getType();
+      resp.sensors.values[i].value = sensor->value;
+      nextSensor = (nextSensor + 1) % sensors.getCount();
+      PRINT(F("sensor "));
+      PRINT(sensor->getType());
+      PRINT(F(": "));
+      PRINTLN(sensor->value);
+    } else {
+      resp.sensors.values[i].type = SENSOR_TYPE_NONE;
+      resp.sensors.values[i].value = 0;
+    }
+  }
+  queueResponse(&resp);
+}
+
+bool RxController::queueResponse(const ResponsePacket *resp) {
+  if (responseCount == RESPONSE_QUEUE_LENGTH) return false;
+  memcpy(
+    &responseQueue[(responseHead + responseCount) % RESPONSE_QUEUE_LENGTH],
+    resp,
+    sizeof(ResponsePacket)
+  );
+  responseCount++;
+  return true;
+}
+
+bool RxController::sendQueuedResponse() {
+  ResponsePacket *resp = &responseQueue[responseHead];
+
+  if (responseCount == 0) return false;
+  // Time spent in the queue is taken out of the round trip
+  if (resp->generic.packetType == PACKET_TYPE_PONG)
+    resp->pong.replyTime = micros();
+  receiver->send(resp);
+  responseHead = (responseHead + 1) % RESPONSE_QUEUE_LENGTH;
+  responseCount--;
+  return true;
+}
+
+bool RxController::addSensor(BaseSensor *sensor) {
+  return sensors.add(sensor);
+}
+
+void RxController::setStabilizer(Stabilizer *value) {
+  stabilizer = value;
+}
+
+#ifdef WITH_TIMING_STATS
+// Prints all probes to console and sends one of them, in turn, to the
+// transmitter. Stats are collected again for the next interval.
+void RxController::reportTimingStats() {
+  ResponsePacket resp;
+  TimingStats *stats;
+
+  timingStats[TIMING_PROBE_RECEIVE].print(F("receive"));
+  timingStats[TIMING_PROBE_HANDLE_PACKET].print(F("handlePacket"));
+  timingStats[TIMING_PROBE_APPLY].print(F("apply"));
+  timingStats[TIMING_PROBE_LATENCY].print(F("latency"));
+  timingStats[TIMING_PROBE_LOOP].print(F("loop"));
+
+  stats = &timingStats[timingStatsProbe];
+  resp.timingStats.packetType = PACKET_TYPE_TIMING_STATS;
+  resp.timingStats.probe = timingStatsProbe;
+  resp.timingStats.minValue = min(stats->minValue, 0xffffUL);
+  resp.timingStats.avgValue = min(stats->getAverage(), 0xffffUL);
+  resp.timingStats.maxValue = min(stats->maxValue, 0xffffUL);
+  for (uint8_t i = 0; i < TIMING_STATS_PACKET_BUCKETS; i++)
+    resp.timingStats.buckets[i] = stats->getBucketShare(i);
+  queueResponse(&resp);
+
+  timingStatsProbe = (timingStatsProbe + 1) % NUM_TIMING_PROBES;
+  for (uint8_t i = 0; i < NUM_TIMING_PROBES; i++)
+    timingStats[i].reset();
+}
+#endif
+
+#ifdef WITH_RF_SCAN
+void RxController::reportRFScan() {
+  ResponsePacket resp;
+
+  resp.rfScan.packetType = PACKET_TYPE_RF_SCAN;
+  resp.rfScan.firstChannel = rfScanReportChannel;
+  for (uint8_t i = 0; i < RF_SCAN_PACKET_CHANNELS; i++) {
+    resp.rfScan.hits[i] = (
+      rfScanReportChannel + i < RF_SCAN_CHANNELS
+      ? rfScan.hits[rfScanReportChannel + i]
+      : 0
+    );
+  }
   receiver->send(&resp);
+
+  rfScanReportChannel += RF_SCAN_PACKET_CHANNELS;
+  if (rfScanReportChannel > RF_SCAN_CHANNELS)
+    rfScanReportChannel = RF_SCAN_CHANNELS;
+}
+#endif
+
+void RxController::writeLed(bool on) {
+  if (ledPin >= 0)
+    led.write(on != isLedInverted);
 }
 
 void RxController::setLedInverted(bool value) {
   isLedInverted = value;
 }
 
+void RxController::setFailsafeMode(ChannelN channel, FailsafeMode mode) {
+  failsafeModes[channel] = mode;
+}
+
+void RxController::setFailsafeRampRate(uint16_t value) {
+  failsafeRampRate = value;
+}
+
+void RxController::setMixerDefaults(const RxMixerSettings *value) {
+  mixerDefaults = value;
+}
+
+void RxController::updateMixer() {
+  mixer.compile(&settings->values.mixer);
+}
+
+uint16_t RxController::getFrameInterval() {
+  return frameInterval >> FRAME_INTERVAL_SHIFT;
+}
+
 // vim:ai:sw=2:et
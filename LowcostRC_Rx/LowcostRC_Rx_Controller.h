@@ -3,15 +3,80 @@
 
 #include <LowcostRC_Protocol.h>
 #include <LowcostRC_VoltMetter.h>
+#include <LowcostRC_Stats.h>
+#include <LowcostRC_RFScan.h>
 #include <LowcostRC_Rx.h>
 #include <LowcostRC_Rx_Settings.h>
 #include <LowcostRC_Output.h>
+#include <LowcostRC_Rx_Mixer.h>
+#include <LowcostRC_Sensor.h>
+#include <LowcostRC_Stabilizer.h>
+
+enum FailsafeStageEnum {
+  FAILSAFE_STAGE_NONE,
+  // A few frames are missing, outputs keep their last values
+  FAILSAFE_STAGE_HOLD,
+  // Link is lost, every channel goes to its failsafe mode
+  FAILSAFE_STAGE_FULL,
+};
+
+typedef uint8_t FailsafeStage;
+
+enum FailsafeModeEnum {
+  // Keep the last received value
+  FAILSAFE_MODE_HOLD,
+  // Jump to the saved failsafe value
+  FAILSAFE_MODE_VALUE,
+  // Move to the saved failsafe value at failsafe ramp rate
+  FAILSAFE_MODE_RAMP,
+};
+
+typedef uint8_t FailsafeMode;
+
+// Responses waiting for a received frame, nRF24 holds only three ack
+// payloads and ESP8266 one
+#ifndef RESPONSE_QUEUE_LENGTH
+#define RESPONSE_QUEUE_LENGTH 4
+#endif
 
 class RxController {
   private:
-    uint16_t lastChannels[NUM_CHANNELS];
+    uint16_t lastChannels[NUM_CHANNELS],
+             failsafeChannels[NUM_CHANNELS];
+    FailsafeMode failsafeModes[NUM_CHANNELS];
+    RxMixer mixer;
+    SensorScheduler sensors;
+    Stabilizer *stabilizer;
+    uint8_t nextSensor;
+    const RxMixerSettings *mixerDefaults;
+    uint16_t frameInterval,
+             failsafeRampRate;
+    unsigned long failsafeTime;
     bool hasLastChannels,
          isLedInverted;
+    OutputPin led;
+    ResponsePacket responseQueue[RESPONSE_QUEUE_LENGTH];
+    uint8_t responseHead,
+            responseCount;
+#ifdef WITH_TIMING_STATS
+    TimingStats timingStats[NUM_TIMING_PROBES];
+    TimingProbe timingStatsProbe;
+
+    void reportTimingStats();
+#endif
+#ifdef WITH_RF_SCAN
+    RFScan rfScan;
+    // First channel of the next reported group, RF_SCAN_CHANNELS when done
+    RFChannel rfScanReportChannel;
+
+    void reportRFScan();
+#endif
+
+    // Sends the oldest queued response, false when there is none
+    bool sendQueuedResponse();
+    void writeLed(bool on);
+    void handleFailsafe(unsigned long now);
+    void applyFailsafe(unsigned long elapsed);
 
   public:
     BaseRxSettings *settings;
@@ -21,7 +86,11 @@ class RxController {
 
     int pairPin, ledPin;
     unsigned long controlTime, telemetryTime;
+    // micros() when the handled packet was received, arrival time when the
+    // radio tells it
+    unsigned long packetTime;
     bool isFailsafe;
+    FailsafeStage failsafeStage;
 
     RxController(
         BaseRxSettings *settings,
@@ -34,9 +103,28 @@ class RxController {
     virtual bool begin();
     virtual void handle();
     virtual void handlePacket(const RequestPacket *rp);
+    // Runs channels through the mixer and applies the result
+    void processControl(const ControlPacket *control);
     virtual void applyControl(const ControlPacket *control);
     virtual void sendTelemetry();
+    // Response goes out after the next received frame, one per frame.
+    // False when the queue is full.
+    bool queueResponse(const ResponsePacket *resp);
+    // Sensors must be added before begin()
+    bool addSensor(BaseSensor *sensor);
+    // Stabilizer must be set before begin()
+    void setStabilizer(Stabilizer *value);
     void setLedInverted(bool value);
+    void setFailsafeMode(ChannelN channel, FailsafeMode mode);
+    // Ramp rate in channel units per second
+    void setFailsafeRampRate(uint16_t value);
+    uint16_t getFrameInterval();
+    // Mixer used instead of identity one when no settings are stored,
+    // value must be in PROGMEM. This is the only way to configure it, the
+    // transmitter mixer is the one edited from the UI.
+    void setMixerDefaults(const RxMixerSettings *value);
+    // Rebuild mixer table after settings->values.mixer change
+    void updateMixer();
 };
 
 #endif // LOWCOSTRC_RX_CONTROLLER_H
@@ -0,0 +1,217 @@
+#include <string.h>
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_Rx_Diversity.h>
+
+// Non-control packets equal to the last one are dropped within this time
+#define DUPLICATE_WINDOW 50
+
+// After this time any sequence is accepted, e.g. transmitter restarted
+#define SEQUENCE_RESYNC_TIMEOUT 500
+
+DiversityReceiver::DiversityReceiver(BaseReceiver **receivers)
+  : numPaths(0),
+    paLevel(DEFAULT_PA_LEVEL),
+    hasPending(false),
+    packetTime(0),
+    hasLastPacket(false),
+    hasLastControl(false),
+    frames(0)
+{
+  for (; numPaths < MAX_DIVERSITY_PATHS && receivers[numPaths] != NULL; numPaths++)
+    paths[numPaths] = receivers[numPaths];
+
+  // First path able to scan, e.g. nRF24 next to ESP-NOW primary
+  scanPath = NULL;
+  for (uint8_t i = 0; i < numPaths && scanPath == NULL; i++)
+    if (paths[i]->canScanRF())
+      scanPath = paths[i];
+
+  for (uint8_t i = 0; i < MAX_DIVERSITY_PATHS; i++) {
+    pathFrames[i] = 0;
+    pathQuality[i] = 0;
+  }
+}
+
+bool DiversityReceiver::begin(const Address *address, RFChannel channel, PALevel level) {
+  paLevel = level;
+
+  if (!paths[0]->begin(address, channel, level))
+    return false;
+
+  // Secondary radios are optional, link still works without them
+  for (uint8_t i = 1; i < numPaths; i++)
+    if (!paths[i]->begin(address, channel, level)) {
+      PRINT(F("Diversity: path init failed: "));
+      PRINTLN(i);
+    }
+
+  return true;
+}
+
+const Address *DiversityReceiver::getAddress() {
+  return paths[0]->getAddress();
+}
+
+const Address *DiversityReceiver::getPeerAddress() {
+  return paths[0]->getPeerAddress();
+}
+
+RFChannel DiversityReceiver::getRFChannel() {
+  return paths[0]->getRFChannel();
+}
+
+void DiversityReceiver::setRFChannel(RFChannel ch) {
+  for (uint8_t i = 0; i < numPaths; i++)
+    paths[i]->setRFChannel(ch);
+}
+
+void DiversityReceiver::setPALevel(PALevel level) {
+  paLevel = level;
+  for (uint8_t i = 0; i < numPaths; i++)
+    paths[i]->setPALevel(level);
+}
+
+// Control frames are compared by sequence only, so other packets in
+// between do not let late copies of older frames through
+bool DiversityReceiver::isDuplicate(const RequestPacket *packet) {
+  unsigned long now = millis();
+
+  if (packet->generic.packetType == PACKET_TYPE_CONTROL) {
+    if (!hasLastControl || now - lastControlTime > SEQUENCE_RESYNC_TIMEOUT)
+      return false;
+    // Late copies of older frames are dropped as well
+    return (int8_t)(packet->control.sequence - lastControlSequence) <= 0;
+  }
+
+  return (
+    hasLastPacket
+    && now - lastPacketTime < DUPLICATE_WINDOW
+    && memcmp(packet, &lastPacket, sizeof(RequestPacket)) == 0
+  );
+}
+
+void DiversityReceiver::remember(const RequestPacket *packet) {
+  if (packet->generic.packetType == PACKET_TYPE_CONTROL) {
+    lastControlSequence = packet->control.sequence;
+    lastControlTime = millis();
+    hasLastControl = true;
+  } else {
+    memcpy(&lastPacket, packet, sizeof(RequestPacket));
+    lastPacketTime = millis();
+    hasLastPacket = true;
+  }
+}
+
+void DiversityReceiver::countFrame(uint8_t path, bool isNew) {
+  pathFrames[path]++;
+  if (!isNew) return;
+
+  if (++frames < DIVERSITY_STATS_FRAMES) return;
+
+  for (uint8_t i = 0; i < numPaths; i++) {
+    pathQuality[i] = min(pathFrames[i], frames) * 100L / frames;
+    pathFrames[i] = 0;
+  }
+  frames = 0;
+}
+
+void DiversityReceiver::deliver(
+    RequestPacket *packet, const RequestPacket *from, uint8_t path
+) {
+  unsigned long time = paths[path]->getPacketTime();
+
+  memcpy(packet, from, sizeof(RequestPacket));
+  packetTime = time > 0 ? time : micros();
+}
+
+bool DiversityReceiver::receive(RequestPacket *packet) {
+  RequestPacket received;
+  bool isNew, isDelivered = false;
+
+  if (hasPending) {
+    deliver(packet, &pending, pendingPath);
+    hasPending = false;
+    isDelivered = true;
+  }
+
+  for (uint8_t i = 0; i < numPaths; i++) {
+    if (!paths[i]->receive(&received)) continue;
+
+    isNew = !isDuplicate(&received);
+    if (received.generic.packetType == PACKET_TYPE_CONTROL)
+      countFrame(i, isNew);
+    if (!isNew) continue;
+
+    remember(&received);
+
+    if (!isDelivered) {
+      deliver(packet, &received, i);
+      isDelivered = true;
+    } else {
+      // Another new frame, keep it for the next call
+      memcpy(&pending, &received, sizeof(RequestPacket));
+      pendingPath = i;
+      hasPending = true;
+    }
+  }
+
+  return isDelivered;
+}
+
+void DiversityReceiver::send(const ResponsePacket *packet) {
+  paths[0]->send(packet);
+}
+
+void DiversityReceiver::startPairing() {
+  pairState = RX_PAIR_STATE_PAIRING;
+  paths[0]->startPairing();
+}
+
+RxPairState DiversityReceiver::handlePairing() {
+  pairState = paths[0]->handlePairing();
+  if (pairState != RX_PAIR_STATE_PAIRED)
+    return pairState;
+
+  // Secondary radios take the address assigned while pairing
+  for (uint8_t i = 1; i < numPaths; i++)
+    paths[i]->begin(paths[0]->getAddress(), paths[0]->getRFChannel(), paLevel);
+  return pairState;
+}
+
+bool DiversityReceiver::isPaired() {
+  return paths[0]->isPaired();
+}
+
+unsigned long DiversityReceiver::getPacketTime() {
+  return packetTime;
+}
+
+bool DiversityReceiver::canScanRF() {
+  return scanPath != NULL;
+}
+
+bool DiversityReceiver::isChannelBusy(RFChannel ch) {
+  return scanPath != NULL && scanPath->isChannelBusy(ch);
+}
+
+uint8_t DiversityReceiver::getPathQuality(uint8_t path) {
+  return path < numPaths ? pathQuality[path] : 0;
+}
+
+PathQualitySensor::PathQualitySensor(DiversityReceiver *receiver, uint8_t path)
+  : BaseSensor(1000, 10),
+    receiver(receiver),
+    path(path)
+{
+}
+
+void PathQualitySensor::sample() {
+  value = receiver->getPathQuality(path);
+}
+
+SensorType PathQualitySensor::getType() {
+  return SENSOR_TYPE_PATH_QUALITY + path;
+}
+
+// vim:et:sw=2:ai
@@ -0,0 +1,81 @@
+#ifndef LOWCOSTRC_RX_DIVERSITY_H
+#define LOWCOSTRC_RX_DIVERSITY_H
+
+#include <LowcostRC_Protocol.h>
+#include <LowcostRC_Rx.h>
+#include <LowcostRC_Sensor.h>
+
+#define MAX_DIVERSITY_PATHS 3
+
+// Unique control frames per path quality update
+#define DIVERSITY_STATS_FRAMES 100
+
+// Receives the same link with several radios and delivers the first copy of
+// every frame. The first receiver is primary, it pairs and sends responses.
+// Other receivers must not acknowledge packets, see
+// NRF24Receiver::setAutoAck().
+class DiversityReceiver : public BaseReceiver {
+  private:
+    BaseReceiver *paths[MAX_DIVERSITY_PATHS];
+    uint8_t numPaths;
+    BaseReceiver *scanPath;
+    PALevel paLevel;
+
+    RequestPacket pending;
+    uint8_t pendingPath;
+    bool hasPending;
+
+    // Last non-control packet and last control frame sequence
+    RequestPacket lastPacket;
+    unsigned long lastPacketTime,
+                  lastControlTime,
+                  packetTime;
+    uint8_t lastControlSequence;
+    bool hasLastPacket,
+         hasLastControl;
+
+    void remember(const RequestPacket *packet);
+
+    uint16_t frames,
+             pathFrames[MAX_DIVERSITY_PATHS];
+    uint8_t pathQuality[MAX_DIVERSITY_PATHS];
+
+    bool isDuplicate(const RequestPacket *packet);
+    void countFrame(uint8_t path, bool isNew);
+    void deliver(RequestPacket *packet, const RequestPacket *from, uint8_t path);
+
+  public:
+    // NULL terminated list, like outputs of RxController
+    DiversityReceiver(BaseReceiver **receivers);
+    virtual bool begin(const Address *address, RFChannel channel, PALevel level);
+    virtual const Address *getAddress();
+    virtual const Address *getPeerAddress();
+    virtual RFChannel getRFChannel();
+    virtual void setRFChannel(RFChannel ch);
+    virtual void setPALevel(PALevel level);
+    virtual bool receive(RequestPacket *packet);
+    virtual void send(const ResponsePacket *packet);
+    virtual void startPairing();
+    virtual RxPairState handlePairing();
+    virtual bool isPaired();
+    virtual unsigned long getPacketTime();
+    virtual bool canScanRF();
+    virtual bool isChannelBusy(RFChannel ch);
+
+    // Percent of unique control frames received by path
+    uint8_t getPathQuality(uint8_t path);
+};
+
+// Reports path quality in sensor telemetry
+class PathQualitySensor : public BaseSensor {
+  private:
+    DiversityReceiver *receiver;
+    uint8_t path;
+  public:
+    PathQualitySensor(DiversityReceiver *receiver, uint8_t path);
+    virtual void sample();
+    virtual SensorType getType();
+};
+
+#endif // LOWCOSTRC_RX_DIVERSITY_H
+// vim:et:sw=2:ai
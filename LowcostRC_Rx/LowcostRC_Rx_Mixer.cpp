@@ -0,0 +1,51 @@
+#include <Arduino.h>
+#include <LowcostRC_Rx_Mixer.h>
+
+void RxMixer::compile(const RxMixerSettings *settings) {
+  const RxMixLine *line;
+  const RxOutputSettings *output;
+
+  numTerms = 0;
+  for (int i = 0; i < RX_MIX_LINES; i++) {
+    line = &settings->lines[i];
+    if (
+        line->source < 0 || line->source >= NUM_CHANNELS
+        || line->output < 0 || line->output >= NUM_CHANNELS
+        || line->weight == 0
+    )
+      continue;
+    terms[numTerms].source = line->source;
+    terms[numTerms].output = line->output;
+    terms[numTerms].weight = (int16_t)line->weight * 256 / 100;
+    numTerms++;
+  }
+
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    output = &settings->outputs[i];
+    centers[i] = RX_CENTER_VALUE + output->subTrim;
+    minValues[i] = output->minValue;
+    maxValues[i] = max(output->minValue, output->maxValue);
+  }
+}
+
+void RxMixer::apply(const ControlPacket *input, ControlPacket *output) {
+  long values[NUM_CHANNELS];
+  const Term *term;
+
+  for (int i = 0; i < NUM_CHANNELS; i++)
+    values[i] = (long)centers[i] << 8;
+
+  for (uint8_t i = 0; i < numTerms; i++) {
+    term = &terms[i];
+    values[term->output] += (
+      (long)((int16_t)input->channels[term->source] - RX_CENTER_VALUE)
+      * term->weight
+    );
+  }
+
+  output->packetType = input->packetType;
+  for (int i = 0; i < NUM_CHANNELS; i++)
+    output->channels[i] = constrain(values[i] >> 8, minValues[i], maxValues[i]);
+}
+
+// vim:et:sw=2:ai
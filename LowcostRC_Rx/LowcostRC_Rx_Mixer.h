@@ -0,0 +1,55 @@
+#ifndef LOWCOSTRC_RX_MIXER_H
+#define LOWCOSTRC_RX_MIXER_H
+
+#include <LowcostRC_Protocol.h>
+
+#define RX_MIX_LINES 8
+#define RX_CENTER_VALUE 1500
+#define RX_MIN_VALUE 0
+#define RX_MAX_VALUE 5000
+
+// Adds weight percent of source channel deviation from center to output.
+// Negative weight reverses, unused lines have NO_CHANNEL source.
+struct RxMixLine {
+  int8_t source,
+         output,
+         weight;
+} __attribute__((__packed__));
+
+struct RxOutputSettings {
+  int8_t subTrim;
+  uint16_t minValue,
+           maxValue;
+} __attribute__((__packed__));
+
+struct RxMixerSettings {
+  RxMixLine lines[RX_MIX_LINES];
+  RxOutputSettings outputs[NUM_CHANNELS];
+} __attribute__((__packed__));
+
+#define RX_MIX_LINE(source, output, weight) {source, output, weight}
+#define RX_MIX_NONE RX_MIX_LINE(NO_CHANNEL, NO_CHANNEL, 0)
+#define RX_OUTPUT_DEFAULT {0, RX_MIN_VALUE, RX_MAX_VALUE}
+
+// Settings compiled into a flat table, weights are 8 bit fixed point
+class RxMixer {
+  private:
+    struct Term {
+      uint8_t source,
+              output;
+      int16_t weight;
+    };
+
+    Term terms[RX_MIX_LINES];
+    uint8_t numTerms;
+    int16_t centers[NUM_CHANNELS];
+    uint16_t minValues[NUM_CHANNELS],
+             maxValues[NUM_CHANNELS];
+
+  public:
+    void compile(const RxMixerSettings *settings);
+    void apply(const ControlPacket *input, ControlPacket *output);
+};
+
+#endif // LOWCOSTRC_RX_MIXER_H
+// vim:et:sw=2:ai
@@ -18,6 +18,28 @@ static const SettingsValues defaults PROGMEM = {
   {
     PACKET_TYPE_CONTROL,
     {0, 0, 0, 0, 0, 0, 0, 0}
+  },
+  {
+    {
+      RX_MIX_LINE(CHANNEL1, CHANNEL1, 100),
+      RX_MIX_LINE(CHANNEL2, CHANNEL2, 100),
+      RX_MIX_LINE(CHANNEL3, CHANNEL3, 100),
+      RX_MIX_LINE(CHANNEL4, CHANNEL4, 100),
+      RX_MIX_LINE(CHANNEL5, CHANNEL5, 100),
+      RX_MIX_LINE(CHANNEL6, CHANNEL6, 100),
+      RX_MIX_LINE(CHANNEL7, CHANNEL7, 100),
+      RX_MIX_LINE(CHANNEL8, CHANNEL8, 100),
+    },
+    {
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+      RX_OUTPUT_DEFAULT,
+    }
   }
 };
 
@@ -37,29 +59,237 @@ bool DumbRxSettings::load() {
 void DumbRxSettings::save() {
 }
 
-bool EEPROMRxSettings::begin() {
 #ifdef ARDUINO_ARCH_ESP8266
+// ESP_EEPROM keeps the whole image in RAM and rotates it across the flash
+// sector itself, so flat structure is stored.
+bool EEPROMRxSettings::begin() {
   EEPROM.begin(sizeof(SettingsValues));
-#endif
+  isChanged = false;
   return true;
 }
 
 bool EEPROMRxSettings::load() {
   PRINTLN(F("Reading settings from flash ROM..."));
-#ifdef ARDUINO_ARCH_ESP8266
   if (EEPROM.percentUsed() < 0)
     return false;
-#endif
   EEPROM.get(SETTINGS_ADDR, values);
   return values.magick == SETTINGS_MAGICK;
 }
 
 void EEPROMRxSettings::save() {
+  isChanged = true;
+  saveTime = millis();
+}
+
+void EEPROMRxSettings::handle() {
+  if (isChanged && millis() - saveTime >= SETTINGS_SAVE_DELAY) {
+    isChanged = false;
+    PRINTLN(F("Writing settings to flash ROM..."));
+    EEPROM.put(SETTINGS_ADDR, values);
+    EEPROM.commit();
+  }
+}
+
+#else
+
+#define BANK_SIZE (SETTINGS_JOURNAL_SIZE / 2)
+#define BANK_ADDR(bank) (SETTINGS_ADDR + (bank) * BANK_SIZE)
+#define RECORD_END 0xff
+
+#define RECORD_LENGTH 0
+#define RECORD_OFFSET 1
+#define RECORD_SEQUENCE 2
+
+static uint8_t crc8(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  return crc;
+}
+
+bool EEPROMRxSettings::begin() {
+  bank = 0;
+  sequence = 0;
+  // Bank is "full", so the first save writes a snapshot to other bank
+  writeAddr = BANK_ADDR(1);
+  recordLength = 0;
+  recordStep = 0;
+  isChanged = false;
+  return true;
+}
+
+// Returns record length if there is a valid record at addr, 0 otherwise
+uint8_t EEPROMRxSettings::readRecord(uint16_t addr, uint16_t end, uint8_t *header) {
+  uint8_t crc = 0, length;
+
+  if (addr + SETTINGS_RECORD_OVERHEAD > end) return 0;
+
+  for (uint8_t i = 0; i < SETTINGS_RECORD_HEADER; i++) {
+    header[i] = EEPROM.read(addr + i);
+    crc = crc8(crc, header[i]);
+  }
+
+  length = header[RECORD_LENGTH];
+  if (
+      length == 0
+      || header[RECORD_OFFSET] + length > sizeof(SettingsValues)
+      || addr + length + SETTINGS_RECORD_OVERHEAD > end
+  )
+    return 0;
+
+  addr += SETTINGS_RECORD_HEADER;
+  for (uint8_t i = 0; i < length; i++)
+    crc = crc8(crc, EEPROM.read(addr + i));
+  if (crc != EEPROM.read(addr + length))
+    return 0;
+
+  return length + SETTINGS_RECORD_OVERHEAD;
+}
+
+void EEPROMRxSettings::copyRecord(
+    uint16_t addr, const uint8_t *header, SettingsValues *dest
+) {
+  uint8_t *data = (uint8_t *)dest + header[RECORD_OFFSET];
+
+  addr += SETTINGS_RECORD_HEADER;
+  for (uint8_t i = 0; i < header[RECORD_LENGTH]; i++)
+    data[i] = EEPROM.read(addr + i);
+}
+
+bool EEPROMRxSettings::readSnapshot(uint8_t bank, uint8_t *header) {
+  uint16_t addr = BANK_ADDR(bank);
+
+  if (readRecord(addr, addr + BANK_SIZE, header) != SETTINGS_RECORD_MAX)
+    return false;
+  if (header[RECORD_OFFSET] != 0)
+    return false;
+  copyRecord(addr, header, &values);
+  return values.magick == SETTINGS_MAGICK;
+}
+
+bool EEPROMRxSettings::load() {
+  uint8_t header[SETTINGS_RECORD_HEADER], length, sequences[2];
+  bool isValid[2];
+  uint16_t addr, end;
+
+  PRINTLN(F("Reading settings from flash ROM..."));
+
+  for (uint8_t i = 0; i < 2; i++) {
+    isValid[i] = readSnapshot(i, header);
+    sequences[i] = header[RECORD_SEQUENCE];
+  }
+
+  if (!isValid[0] && !isValid[1]) {
+    // Settings stored by older firmware without journal. Bank 0 overlaps
+    // them, so first snapshot goes to bank 1.
+    EEPROM.get(SETTINGS_ADDR, values);
+    if (values.magick != SETTINGS_MAGICK)
+      return false;
+    memcpy(&stored, &values, sizeof(SettingsValues));
+    save();
+    return true;
+  }
+
+  if (isValid[0] && isValid[1])
+    bank = (int8_t)(sequences[1] - sequences[0]) > 0 ? 1 : 0;
+  else
+    bank = isValid[1] ? 1 : 0;
+
+  readSnapshot(bank, header);
+  sequence = header[RECORD_SEQUENCE];
+  addr = BANK_ADDR(bank) + SETTINGS_RECORD_MAX;
+  end = BANK_ADDR(bank) + BANK_SIZE;
+
+  while (
+      (length = readRecord(addr, end, header)) > 0
+      && header[RECORD_SEQUENCE] == (uint8_t)(sequence + 1)
+  ) {
+    copyRecord(addr, header, &values);
+    sequence++;
+    addr += length;
+  }
+
+  writeAddr = addr;
+  memcpy(&stored, &values, sizeof(SettingsValues));
+  return values.magick == SETTINGS_MAGICK;
+}
+
+void EEPROMRxSettings::save() {
+  isChanged = true;
+  saveTime = millis();
+}
+
+void EEPROMRxSettings::handle() {
+  if (recordLength > 0) {
+    writeRecord();
+  } else if (isChanged && millis() - saveTime >= SETTINGS_SAVE_DELAY) {
+    isChanged = false;
+    buildRecord();
+  }
+}
+
+void EEPROMRxSettings::buildRecord() {
+  const uint8_t *current = (const uint8_t *)&values,
+                *old = (const uint8_t *)&stored;
+  uint8_t first, last, length, crc = 0;
+  uint16_t end = BANK_ADDR(bank) + BANK_SIZE;
+
+  for (first = 0; first < sizeof(SettingsValues) && current[first] == old[first]; first++);
+  if (first == sizeof(SettingsValues) && writeAddr < end) return;
+  for (last = sizeof(SettingsValues) - 1; last > first && current[last] == old[last]; last--);
+  length = last - first + 1;
+
+  if (writeAddr + length + SETTINGS_RECORD_OVERHEAD > end) {
+    bank ^= 1;
+    writeAddr = BANK_ADDR(bank);
+    end = writeAddr + BANK_SIZE;
+    first = 0;
+    length = sizeof(SettingsValues);
+  }
+
   PRINTLN(F("Writing settings to flash ROM..."));
-  EEPROM.put(SETTINGS_ADDR, values);
-#ifdef ARDUINO_ARCH_ESP8266
-  EEPROM.commit();
-#endif
+
+  sequence++;
+  record[RECORD_LENGTH] = length;
+  record[RECORD_OFFSET] = first;
+  record[RECORD_SEQUENCE] = sequence;
+  memcpy(record + SETTINGS_RECORD_HEADER, current + first, length);
+  for (uint8_t i = 0; i < length + SETTINGS_RECORD_HEADER; i++)
+    crc = crc8(crc, record[i]);
+  record[length + SETTINGS_RECORD_HEADER] = crc;
+
+  recordAddr = writeAddr;
+  recordLength = length + SETTINGS_RECORD_OVERHEAD;
+  writeAddr += recordLength;
+  // Stale records may follow, invalid length marks the end of journal
+  if (writeAddr < end)
+    record[recordLength++] = RECORD_END;
+  recordStep = 0;
+
+  memcpy(&stored, &values, sizeof(SettingsValues));
+
+  writeRecord();
 }
 
+// Record length byte is invalidated first and written last, so record
+// becomes valid only when it is complete.
+void EEPROMRxSettings::writeRecord() {
+  // One byte per call, never wait for EEPROM
+  if (!eeprom_is_ready()) return;
+
+  if (recordStep == 0)
+    EEPROM.update(recordAddr + RECORD_LENGTH, RECORD_END);
+  else if (recordStep < recordLength)
+    EEPROM.update(recordAddr + recordStep, record[recordStep]);
+  else
+    EEPROM.update(recordAddr + RECORD_LENGTH, record[RECORD_LENGTH]);
+
+  if (recordStep < recordLength)
+    recordStep++;
+  else
+    recordLength = recordStep = 0;
+}
+
+#endif // ARDUINO_ARCH_ESP8266
+
 // vim:et:sw=2:ai
@@ -2,9 +2,20 @@
 #define LOWCOSTRC_RX_SETTINGS_H
 
 #include <LowcostRC_Protocol.h>
+#include <LowcostRC_Rx_Mixer.h>
 
 #define SETTINGS_ADDR 0
-#define SETTINGS_MAGICK 0x1235
+#define SETTINGS_MAGICK 0x1237
+
+// EEPROM area used by settings journal, split into two banks
+#ifndef SETTINGS_JOURNAL_SIZE
+#define SETTINGS_JOURNAL_SIZE 512
+#endif
+
+// Changes are collected for this time (ms) before written
+#ifndef SETTINGS_SAVE_DELAY
+#define SETTINGS_SAVE_DELAY 500
+#endif
 
 struct SettingsValues {
   uint16_t magick;
@@ -12,6 +23,7 @@ struct SettingsValues {
   RFChannel rfChannel;
   PALevel paLevel;
   ControlPacket failsafe;
+  RxMixerSettings mixer;
 } __attribute__((__packed__));
 
 
@@ -22,6 +34,7 @@ class BaseRxSettings {
     virtual bool begin() = 0;
     virtual bool load() = 0;
     virtual void save() = 0;
+    virtual void handle() {};
     void setDefaults();
 };
 
@@ -31,10 +44,41 @@ class DumbRxSettings : public BaseRxSettings {
     virtual void save();
 };
 
+// Length, offset, sequence, data, CRC
+#define SETTINGS_RECORD_HEADER 3
+#define SETTINGS_RECORD_OVERHEAD (SETTINGS_RECORD_HEADER + 1)
+#define SETTINGS_RECORD_MAX (sizeof(SettingsValues) + SETTINGS_RECORD_OVERHEAD)
+
+// save() only marks settings as changed, they are written from handle()
+// when the controller is idle. On AVR settings journal is used: each bank
+// starts with a full snapshot record followed by records of changed bytes.
+// When a bank is full, a new snapshot is written to the other bank.
 class EEPROMRxSettings : public BaseRxSettings {
+  private:
+    unsigned long saveTime;
+    bool isChanged;
+#ifndef ARDUINO_ARCH_ESP8266
+    SettingsValues stored;
+    // Record plus end mark
+    uint8_t record[SETTINGS_RECORD_MAX + 1];
+    uint8_t recordLength,
+            recordStep,
+            bank,
+            sequence;
+    uint16_t recordAddr,
+             writeAddr;
+
+    uint8_t readRecord(uint16_t addr, uint16_t end, uint8_t *header);
+    void copyRecord(uint16_t addr, const uint8_t *header, SettingsValues *dest);
+    bool readSnapshot(uint8_t bank, uint8_t *header);
+    void buildRecord();
+    void writeRecord();
+#endif
+  public:
     virtual bool begin();
     virtual bool load();
     virtual void save();
+    virtual void handle();
 };
 
 #endif // LOWCOSTRC_RX_SETTINGS_H
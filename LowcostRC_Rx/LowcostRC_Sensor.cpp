@@ -0,0 +1,220 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_ADC.h>
+#include <LowcostRC_Sensor.h>
+
+#define RPM_TIMEOUT 1000000L
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+BaseSensor::BaseSensor(unsigned long period, unsigned int cost)
+  : period(period),
+    cost(cost),
+    sampleTime(0),
+    value(0)
+{
+}
+
+SensorScheduler::SensorScheduler()
+  : numSensors(0),
+    next(0),
+    loopTime(0),
+    loopCount(0),
+    loopTimeMax(0)
+{
+}
+
+bool SensorScheduler::add(BaseSensor *sensor) {
+  if (numSensors >= MAX_SENSORS) return false;
+  sensors[numSensors++] = sensor;
+  return true;
+}
+
+void SensorScheduler::begin() {
+  for (uint8_t i = 0; i < numSensors; i++)
+    sensors[i]->begin(this);
+  ADCSampler::begin();
+}
+
+void SensorScheduler::handle(bool isIdle) {
+  unsigned long now = micros(),
+                nowMillis,
+                start = now;
+  BaseSensor *sensor;
+  uint8_t i;
+  bool hasRun = false;
+
+  if (loopTime > 0) {
+    loopTimeMax = max(loopTimeMax, now - loopTime);
+    loopCount++;
+  }
+  loopTime = now;
+
+  if (!isIdle) return;
+
+  nowMillis = millis();
+  for (uint8_t n = 0; n < numSensors; n++) {
+    i = next;
+    sensor = sensors[i];
+    if (nowMillis - sensor->sampleTime < sensor->period) {
+      next = (i + 1) % numSensors;
+      continue;
+    }
+    // The first due sensor always runs, so costly ones are not starved
+    if (hasRun && micros() - start + sensor->cost > SENSOR_TIME_BUDGET)
+      break;
+    sensor->sample();
+    sensor->sampleTime = nowMillis;
+    hasRun = true;
+    next = (i + 1) % numSensors;
+  }
+}
+
+uint8_t SensorScheduler::getCount() {
+  return numSensors;
+}
+
+BaseSensor *SensorScheduler::get(uint8_t i) {
+  return sensors[i];
+}
+
+static unsigned int readMillivolts(int8_t slot) {
+  return (
+    ((unsigned long)ADCSampler::readFine(slot) * ADCSampler::readVccMillivolts())
+    >> ADC_FINE_BITS
+  ) / 1024;
+}
+
+CurrentSensor::CurrentSensor(
+    int pin, unsigned int millivoltsPerAmp, unsigned int zeroMillivolts
+) : BaseSensor(100, 40),
+    pin(pin),
+    slot(ADC_SLOT_NONE),
+    millivoltsPerAmp(millivoltsPerAmp),
+    zeroMillivolts(zeroMillivolts)
+{
+}
+
+void CurrentSensor::begin(SensorScheduler *scheduler) {
+  slot = ADCSampler::addChannel(pin, 2);
+#ifdef ARDUINO_ARCH_AVR
+  ADCSampler::addChannel(ADC_BANDGAP, 4);
+#endif
+}
+
+void CurrentSensor::sample() {
+  long millivolts = readMillivolts(slot);
+
+  value = constrain(
+    (millivolts - zeroMillivolts) * 1000L / millivoltsPerAmp, -32767L, 32767L
+  );
+}
+
+SensorType CurrentSensor::getType() {
+  return SENSOR_TYPE_CURRENT;
+}
+
+TemperatureSensor::TemperatureSensor(int pin)
+  : BaseSensor(1000, 40),
+    pin(pin),
+    slot(ADC_SLOT_NONE)
+{
+}
+
+void TemperatureSensor::begin(SensorScheduler *scheduler) {
+  slot = ADCSampler::addChannel(pin, 4);
+#ifdef ARDUINO_ARCH_AVR
+  ADCSampler::addChannel(ADC_BANDGAP, 4);
+#endif
+}
+
+void TemperatureSensor::sample() {
+  // 10 mV per degree, 500 mV at 0 C
+  value = (int)readMillivolts(slot) - 500;
+}
+
+SensorType TemperatureSensor::getType() {
+  return SENSOR_TYPE_TEMPERATURE;
+}
+
+static volatile unsigned long rpmPulseTime = 0;
+static volatile uint16_t rpmPulses = 0;
+static bool isRPMAttached = false;
+
+static void IRAM_ATTR onRPMPulse() {
+  rpmPulseTime = micros();
+  rpmPulses++;
+}
+
+RPMSensor::RPMSensor(int pin, uint8_t pulsesPerRevolution)
+  : BaseSensor(250, 60),
+    pin(pin),
+    pulsesPerRevolution(pulsesPerRevolution),
+    lastPulseTime(0)
+{
+}
+
+void RPMSensor::begin(SensorScheduler *scheduler) {
+  if (isRPMAttached) {
+    PRINTLN(F("RPM: Error: Only one sensor instance allowed"));
+    return;
+  }
+  isRPMAttached = true;
+  pinMode(pin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(pin), onRPMPulse, FALLING);
+}
+
+void RPMSensor::sample() {
+  unsigned long pulseTime, period;
+  uint16_t pulses;
+
+  noInterrupts();
+  pulseTime = rpmPulseTime;
+  pulses = rpmPulses;
+  rpmPulses = 0;
+  interrupts();
+
+  if (pulses == 0) {
+    if (micros() - lastPulseTime > RPM_TIMEOUT) {
+      value = 0;
+      lastPulseTime = 0;
+    }
+    return;
+  }
+
+  if (lastPulseTime > 0) {
+    period = (pulseTime - lastPulseTime) / pulses * pulsesPerRevolution;
+    if (period > 0)
+      value = min(60000000UL / period, 32767UL);
+  }
+  lastPulseTime = pulseTime;
+}
+
+SensorType RPMSensor::getType() {
+  return SENSOR_TYPE_RPM;
+}
+
+LoopTimeSensor::LoopTimeSensor()
+  : BaseSensor(1000, 10),
+    scheduler(NULL)
+{
+}
+
+void LoopTimeSensor::begin(SensorScheduler *scheduler) {
+  this->scheduler = scheduler;
+}
+
+void LoopTimeSensor::sample() {
+  if (scheduler == NULL) return;
+  value = min(scheduler->loopTimeMax, 32767UL);
+  scheduler->loopTimeMax = 0;
+  scheduler->loopCount = 0;
+}
+
+SensorType LoopTimeSensor::getType() {
+  return SENSOR_TYPE_LOOP_TIME;
+}
+
+// vim:et:sw=2:ai
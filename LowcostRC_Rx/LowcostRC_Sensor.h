@@ -0,0 +1,101 @@
+#ifndef LOWCOSTRC_SENSOR_H
+#define LOWCOSTRC_SENSOR_H
+
+#include <LowcostRC_Protocol.h>
+
+#define MAX_SENSORS 8
+
+// Time (us) sensors may use on each idle loop pass
+#ifndef SENSOR_TIME_BUDGET
+#define SENSOR_TIME_BUDGET 500
+#endif
+
+class SensorScheduler;
+
+class BaseSensor {
+  public:
+    // Sample period (ms) and expected sample() duration (us)
+    unsigned long period;
+    unsigned int cost;
+    unsigned long sampleTime;
+    int16_t value;
+
+    BaseSensor(unsigned long period, unsigned int cost);
+    virtual void begin(SensorScheduler *scheduler) {};
+    // Updates value, must not block
+    virtual void sample() = 0;
+    virtual SensorType getType() = 0;
+};
+
+// Runs due sensors on idle loop passes within time budget
+class SensorScheduler {
+  private:
+    BaseSensor *sensors[MAX_SENSORS];
+    uint8_t numSensors,
+            next;
+    unsigned long loopTime;
+
+  public:
+    unsigned long loopCount,
+                  loopTimeMax;
+
+    SensorScheduler();
+    bool add(BaseSensor *sensor);
+    void begin();
+    void handle(bool isIdle);
+    uint8_t getCount();
+    BaseSensor *get(uint8_t i);
+};
+
+// Hall effect current sensor like ACS712
+class CurrentSensor : public BaseSensor {
+  private:
+    int pin;
+    int8_t slot;
+    unsigned int millivoltsPerAmp,
+                 zeroMillivolts;
+  public:
+    CurrentSensor(int pin, unsigned int millivoltsPerAmp, unsigned int zeroMillivolts);
+    virtual void begin(SensorScheduler *scheduler);
+    virtual void sample();
+    virtual SensorType getType();
+};
+
+// TMP36 analog temperature sensor
+class TemperatureSensor : public BaseSensor {
+  private:
+    int pin;
+    int8_t slot;
+  public:
+    TemperatureSensor(int pin);
+    virtual void begin(SensorScheduler *scheduler);
+    virtual void sample();
+    virtual SensorType getType();
+};
+
+// Counts pulses on external interrupt pin, only one instance allowed
+class RPMSensor : public BaseSensor {
+  private:
+    int pin;
+    uint8_t pulsesPerRevolution;
+    unsigned long lastPulseTime;
+  public:
+    RPMSensor(int pin, uint8_t pulsesPerRevolution = 1);
+    virtual void begin(SensorScheduler *scheduler);
+    virtual void sample();
+    virtual SensorType getType();
+};
+
+// Longest controller loop pass since previous sample
+class LoopTimeSensor : public BaseSensor {
+  private:
+    SensorScheduler *scheduler;
+  public:
+    LoopTimeSensor();
+    virtual void begin(SensorScheduler *scheduler);
+    virtual void sample();
+    virtual SensorType getType();
+};
+
+#endif // LOWCOSTRC_SENSOR_H
+// vim:et:sw=2:ai
@@ -0,0 +1,258 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <LowcostRC_Console.h>
+#include <LowcostRC_Rx_Mixer.h>
+#include <LowcostRC_Stabilizer.h>
+
+#define MPU6050_SMPLRT_DIV 0x19
+#define MPU6050_CONFIG 0x1a
+#define MPU6050_GYRO_CONFIG 0x1b
+#define MPU6050_FIFO_EN 0x23
+#define MPU6050_USER_CTRL 0x6a
+#define MPU6050_PWR_MGMT_1 0x6b
+#define MPU6050_FIFO_COUNTH 0x72
+#define MPU6050_FIFO_R_W 0x74
+
+#define FIFO_EN_GYRO 0x70
+#define USER_CTRL_FIFO_EN 0x40
+#define USER_CTRL_FIFO_RESET 0x04
+#define PWR_MGMT_1_CLK_GYRO_X 0x01
+#define GYRO_CONFIG_500DPS 0x08
+#define CONFIG_DLPF_42HZ 0x03
+
+#define GYRO_SAMPLE_RATE 1000
+#define GYRO_COUNTS_PER_DPS_X10 655
+#define FIFO_SAMPLE_SIZE 6
+#define FIFO_OVERFLOW_COUNT 1000
+
+#ifndef BUFFER_LENGTH
+#define BUFFER_LENGTH 32
+#endif
+
+#define BURST_SAMPLES (BUFFER_LENGTH / FIFO_SAMPLE_SIZE)
+
+#define CALIBRATION_SAMPLES 256
+#define MAX_CORRECTION 400
+#define MAX_INTEGRAL (200L << 12)
+
+Stabilizer::Stabilizer(uint8_t address, uint16_t rate)
+  : address(address),
+    period(1000000L / rate),
+    isStarted(false),
+    gainChannel(NO_CHANNEL),
+    missedTicks(0)
+{
+  for (uint8_t i = 0; i < STABILIZER_AXES; i++) {
+    axes[i].channel = NO_CHANNEL;
+    axes[i].gyroAxis = i;
+    axes[i].isReversed = false;
+    axes[i].maxRate = 200;
+    axes[i].kp = 64;
+    axes[i].ki = 4;
+    axes[i].kd = 0;
+    gyroOffsets[i] = 0;
+    gyro[i] = prevGyro[i] = 0;
+    corrections[i] = 0;
+    integrals[i] = 0;
+  }
+}
+
+void Stabilizer::writeRegister(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
+}
+
+bool Stabilizer::begin() {
+  Wire.begin();
+  Wire.setClock(400000L);
+
+  Wire.beginTransmission(address);
+  if (Wire.endTransmission() != 0) {
+    PRINTLN(F("Stabilizer: init: FAIL"));
+    return false;
+  }
+
+  writeRegister(MPU6050_PWR_MGMT_1, PWR_MGMT_1_CLK_GYRO_X);
+  writeRegister(MPU6050_CONFIG, CONFIG_DLPF_42HZ);
+  writeRegister(MPU6050_SMPLRT_DIV, 0);
+  writeRegister(MPU6050_GYRO_CONFIG, GYRO_CONFIG_500DPS);
+  writeRegister(MPU6050_FIFO_EN, FIFO_EN_GYRO);
+  writeRegister(MPU6050_USER_CTRL, USER_CTRL_FIFO_EN | USER_CTRL_FIFO_RESET);
+
+  calibrate();
+  reset();
+
+  isStarted = true;
+  PRINTLN(F("Stabilizer: init: OK"));
+  return true;
+}
+
+// Model must stay still while powered on
+void Stabilizer::calibrate() {
+  long sums[STABILIZER_AXES] = {0, 0, 0};
+  uint16_t count = 0, tries = 0;
+
+  while (count < CALIBRATION_SAMPLES && tries++ < 2 * CALIBRATION_SAMPLES) {
+    delay(10);
+    if (!readGyro()) continue;
+    for (uint8_t i = 0; i < STABILIZER_AXES; i++)
+      sums[i] += gyro[i];
+    count++;
+  }
+
+  for (uint8_t i = 0; i < STABILIZER_AXES; i++) {
+    gyroOffsets[i] = count > 0 ? sums[i] / count : 0;
+    gyro[i] = prevGyro[i] = 0;
+  }
+}
+
+uint16_t Stabilizer::readFIFOCount() {
+  uint16_t count;
+
+  Wire.beginTransmission(address);
+  Wire.write(MPU6050_FIFO_COUNTH);
+  Wire.endTransmission(false);
+  Wire.requestFrom(address, (uint8_t)2);
+  count = Wire.read() << 8;
+  count |= Wire.read();
+  return count;
+}
+
+// Averages all samples collected since previous read
+bool Stabilizer::readGyro() {
+  long sums[STABILIZER_AXES] = {0, 0, 0};
+  uint16_t samples, total;
+  uint8_t burst;
+
+  samples = readFIFOCount();
+  if (samples >= FIFO_OVERFLOW_COUNT) {
+    writeRegister(MPU6050_USER_CTRL, USER_CTRL_FIFO_EN | USER_CTRL_FIFO_RESET);
+    return false;
+  }
+  samples /= FIFO_SAMPLE_SIZE;
+  if (samples == 0) return false;
+
+  for (total = samples; samples > 0; samples -= burst) {
+    burst = min(samples, (uint16_t)BURST_SAMPLES);
+    Wire.beginTransmission(address);
+    Wire.write(MPU6050_FIFO_R_W);
+    Wire.endTransmission(false);
+    Wire.requestFrom(address, (uint8_t)(burst * FIFO_SAMPLE_SIZE));
+    for (uint8_t i = 0; i < burst; i++) {
+      for (uint8_t j = 0; j < STABILIZER_AXES; j++) {
+        int16_t value = Wire.read() << 8;
+        value |= Wire.read();
+        sums[j] += value;
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < STABILIZER_AXES; i++) {
+    prevGyro[i] = gyro[i];
+    gyro[i] = sums[i] / total - gyroOffsets[i];
+  }
+  return true;
+}
+
+void Stabilizer::reset() {
+  tickTime = micros();
+  for (uint8_t i = 0; i < STABILIZER_AXES; i++)
+    integrals[i] = 0;
+}
+
+bool Stabilizer::handle(const uint16_t *channels) {
+  unsigned long now = micros(),
+                interval = now - tickTime;
+  uint8_t gain = 255;
+
+  if (!isStarted || interval < period) return false;
+
+  intervalStats.add(interval);
+  if (interval >= 2 * period) {
+    missedTicks += interval / period - 1;
+    tickTime = now;
+  } else {
+    tickTime += period;
+  }
+
+  if (gainChannel != NO_CHANNEL)
+    gain = constrain(
+      ((long)channels[gainChannel] - 1000) * 255 / 1000, 0L, 255L
+    );
+
+  if (readGyro())
+    update(gain, channels);
+
+  tickStats.add(micros() - now);
+  return true;
+}
+
+void Stabilizer::update(uint8_t gain, const uint16_t *channels) {
+  StabilizerAxis *axis;
+  long setpoint, error, output;
+  int16_t measured, delta;
+
+  for (uint8_t i = 0; i < STABILIZER_AXES; i++) {
+    axis = &axes[i];
+    if (axis->channel == NO_CHANNEL) {
+      corrections[i] = 0;
+      continue;
+    }
+
+    measured = gyro[axis->gyroAxis];
+    delta = measured - prevGyro[axis->gyroAxis];
+    if (axis->isReversed) {
+      measured = -measured;
+      delta = -delta;
+    }
+
+    // Stick deflection requests rotation rate, in gyro counts
+    setpoint = (
+      ((long)channels[axis->channel] - RX_CENTER_VALUE)
+      * axis->maxRate * GYRO_COUNTS_PER_DPS_X10 / 10 / 500
+    );
+    error = setpoint - measured;
+
+    if (gain > 0)
+      integrals[i] = constrain(
+        integrals[i] + error * axis->ki, -MAX_INTEGRAL, MAX_INTEGRAL
+      );
+    else
+      integrals[i] = 0;
+
+    output = (
+      error * axis->kp + integrals[i] - (long)delta * axis->kd
+    ) >> 12;
+    output = constrain(output, (long)-MAX_CORRECTION, (long)MAX_CORRECTION);
+
+    corrections[i] = output * gain / 255;
+  }
+}
+
+void Stabilizer::apply(ControlPacket *control) {
+  StabilizerAxis *axis;
+  long value;
+
+  if (!isStarted) return;
+
+  for (uint8_t i = 0; i < STABILIZER_AXES; i++) {
+    axis = &axes[i];
+    if (axis->channel == NO_CHANNEL) continue;
+    value = (long)control->channels[axis->channel] + corrections[i];
+    control->channels[axis->channel] = constrain(value, 0L, (long)RX_MAX_VALUE);
+  }
+}
+
+void Stabilizer::printStats() {
+  tickStats.print(F("stabilizer tick"));
+  intervalStats.print(F("stabilizer interval"));
+  PRINT(F("stabilizer missed ticks: "));
+  PRINTLN(missedTicks);
+  tickStats.reset();
+  intervalStats.reset();
+  missedTicks = 0;
+}
+
+// vim:et:sw=2:ai
@@ -0,0 +1,72 @@
+#ifndef LOWCOSTRC_STABILIZER_H
+#define LOWCOSTRC_STABILIZER_H
+
+#include <LowcostRC_Protocol.h>
+#include <LowcostRC_Stats.h>
+
+#define STABILIZER_DEFAULT_ADDRESS 0x68
+#define STABILIZER_DEFAULT_RATE 250
+#define STABILIZER_AXES 3
+
+enum GyroAxisEnum {
+  GYRO_AXIS_X,
+  GYRO_AXIS_Y,
+  GYRO_AXIS_Z,
+};
+
+// Gains are 12 bit fixed point factors from gyro counts (65.5 per deg/s) to
+// output microseconds, so kp = 64 gives about 1us per deg/s of error.
+struct StabilizerAxis {
+  ChannelN channel;   // Corrected channel, NO_CHANNEL disables axis
+  uint8_t gyroAxis;
+  bool isReversed;
+  uint16_t maxRate;   // deg/s requested by full stick
+  uint8_t kp, ki, kd;
+};
+
+// Rate stabilizer with MPU6050 gyro. Samples are collected by MPU6050 FIFO
+// at 1kHz and read in bursts once per tick. PID runs at fixed rate,
+// independent of radio frames.
+class Stabilizer {
+  private:
+    uint8_t address;
+    unsigned long period,
+                  tickTime;
+    int16_t gyroOffsets[STABILIZER_AXES],
+            gyro[STABILIZER_AXES],
+            prevGyro[STABILIZER_AXES],
+            corrections[STABILIZER_AXES];
+    long integrals[STABILIZER_AXES];
+    bool isStarted;
+
+    void writeRegister(uint8_t reg, uint8_t value);
+    uint16_t readFIFOCount();
+    bool readGyro();
+    void calibrate();
+    void update(uint8_t gain, const uint16_t *channels);
+
+  public:
+    StabilizerAxis axes[STABILIZER_AXES];
+    // Channel that scales corrections from 0 at 1000 to 100% at 2000,
+    // NO_CHANNEL means always 100%
+    ChannelN gainChannel;
+    TimingStats tickStats,
+                intervalStats;
+    uint16_t missedTicks;
+
+    Stabilizer(
+        uint8_t address = STABILIZER_DEFAULT_ADDRESS,
+        uint16_t rate = STABILIZER_DEFAULT_RATE
+    );
+    bool begin();
+    // Restarts ticks and clears integrals
+    void reset();
+    // Returns true on tick, when corrections are updated
+    bool handle(const uint16_t *channels);
+    // Adds corrections to channels
+    void apply(ControlPacket *control);
+    void printStats();
+};
+
+#endif // LOWCOSTRC_STABILIZER_H
+// vim:et:sw=2:ai
@@ -19,7 +19,6 @@ ESP8266Receiver::ESP8266Receiver()
     peer(ADDRESS_NONE),
     requestTime(0),
     receiveTime(0),
-    isPairing(false),
     _isPaired(false)
 {
   if (receiver == NULL) {
@@ -55,7 +54,7 @@ void ESP8266Receiver::_onDataRecv(uint8_t *mac,  uint8_t *incomingData, uint8_t
     return;
   }
 
-  if (!isPairing) {
+  if (!isPairing()) {
     if (!_isPaired) {
       PRINTLN("ESP: Ignoring packet in unpaired state");
       return;
@@ -70,6 +69,9 @@ void ESP8266Receiver::_onDataRecv(uint8_t *mac,  uint8_t *incomingData, uint8_t
   memcpy(&request, incomingData, sizeof(RequestPacket));
   memcpy(requestMac, mac, sizeof(requestMac));
   requestTime = millis();
+#ifdef WITH_TIMING_STATS
+  requestMicros = micros();
+#endif
 }
 
 bool ESP8266Receiver::begin(const Address *address, RFChannel channel, PALevel level) {
@@ -131,6 +133,9 @@ bool ESP8266Receiver::receive(RequestPacket *packet) {
 
   memcpy(packet, &request, sizeof(RequestPacket));
   receiveTime = requestTime;
+#ifdef WITH_TIMING_STATS
+  packetMicros = requestMicros;
+#endif
   return true;
 }
 
@@ -140,62 +145,39 @@ void ESP8266Receiver::send(const ResponsePacket *packet) {
   }
 }
 
-bool ESP8266Receiver::pair() {
-  RequestPacket req;
+// Answered right away from the loop pass that received INIT
+void ESP8266Receiver::sendPairReady(const PairPacket *request) {
   ResponsePacket resp;
-  int readyCount = 0;
-
-  PRINTLN("ESP: Starting pairing");
-  isPairing = true;
-
-  for (
-    unsigned long start = millis();
-    millis() - start < 10000;
-  ) {
-    if (receive(&req)) {
-      if (req.pair.packetType != PACKET_TYPE_PAIR) {
-        PRINTLN("ESP: Ignoring non-pair type packet");
-        continue;
-      }
 
-      readyCount = 0;
-      ensurePeerExist(requestMac, rfChannelToWifi(DEFAULT_RF_CHANNEL));
-
-      if (req.pair.status == PAIR_STATUS_INIT) {
-        PRINT("ESP: Ready to pair in session: ");
-        PRINTLN(req.pair.session);
-        resp.pair.packetType = PACKET_TYPE_PAIR;
-        resp.pair.status = PAIR_STATUS_READY;
-        resp.pair.session = req.pair.session;
-        WiFi.macAddress(resp.pair.sender.address);
-        readyCount = 10;
-      } else if (req.pair.status == PAIR_STATUS_PAIRED) {
-        PRINTLN("ESP: Paired");
-        isPairing = false;
-        _isPaired = true;
-        memcpy(peer.address, requestMac, ADDRESS_LENGTH);
-        return true;
-      }
-    } else {
-      delay(50);
-    }
-    if (readyCount) {
-      readyCount--;
-      PRINTLN("ESP: Sending pair ready response");
-      if (esp_now_send(requestMac, (uint8_t*)&resp, sizeof(ResponsePacket)) != ESP_OK) {
-        PRINTLN("ESP: Error sending pair ready response");
-      }
-      delay(5);
-    }
-  };
+  PRINT("ESP: Ready to pair in session: ");
+  PRINTLN(request->session);
+  ensurePeerExist(requestMac, rfChannelToWifi(DEFAULT_RF_CHANNEL));
+  resp.pair.packetType = PACKET_TYPE_PAIR;
+  resp.pair.status = PAIR_STATUS_READY;
+  resp.pair.session = request->session;
+  WiFi.macAddress(resp.pair.sender.address);
+  if (esp_now_send(requestMac, (uint8_t*)&resp, sizeof(ResponsePacket)) != ESP_OK) {
+    PRINTLN("ESP: Error sending pair ready response");
+  }
+}
+
+void ESP8266Receiver::leavePairing(bool isPaired) {
+  if (!isPaired) return;
 
-  PRINTLN("ESP: Not paired");
-  isPairing = false;
-  return false;
+  _isPaired = true;
+  memcpy(peer.address, requestMac, ADDRESS_LENGTH);
+  rfChannel = DEFAULT_RF_CHANNEL;
+  ensurePeerExist(peer.address, rfChannelToWifi(rfChannel));
 }
 
 bool ESP8266Receiver::isPaired() {
   return _isPaired;
 }
 
+#ifdef WITH_TIMING_STATS
+unsigned long ESP8266Receiver::getPacketTime() {
+  return packetMicros;
+}
+#endif
+
 // vim:ai:sw=2:et
@@ -12,10 +12,17 @@ class ESP8266Receiver : public BaseReceiver {
     uint8_t requestMac[6];
     unsigned long requestTime,
                   receiveTime;
-    bool isPairing, _isPaired;
+#ifdef WITH_TIMING_STATS
+    unsigned long requestMicros,
+                  packetMicros;
+#endif
+    bool _isPaired;
 
     uint8_t rfChannelToWifi(RFChannel ch);
     void ensurePeerExist(uint8_t *mac, uint8_t wifiChannel);
+  protected:
+    virtual void sendPairReady(const PairPacket *request);
+    virtual void leavePairing(bool isPaired);
   public:
 
     ESP8266Receiver();
@@ -27,8 +34,10 @@ class ESP8266Receiver : public BaseReceiver {
     virtual void setPALevel(PALevel level);
     virtual bool receive(RequestPacket *packet);
     virtual void send(const ResponsePacket *packet);
-    virtual bool pair();
     virtual bool isPaired();
+#ifdef WITH_TIMING_STATS
+    virtual unsigned long getPacketTime();
+#endif
 
     void _onDataRecv(uint8_t * mac,  uint8_t *incomingData, uint8_t len);
 };
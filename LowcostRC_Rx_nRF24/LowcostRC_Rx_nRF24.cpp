@@ -7,9 +7,14 @@
 #define NRF24_DATA_RATE RF24_250KBPS
 #endif
 
+// Receiver must listen this long (us) before RPD is valid
+#define NRF24_RPD_TIME 170
+
 NRF24Receiver::NRF24Receiver(uint8_t cepin, uint8_t cspin)
   : rf24(cepin, cspin),
-    address(ADDRESS_NONE)
+    cePin(cepin),
+    address(ADDRESS_NONE),
+    isAutoAck(true)
 {
 }
 
@@ -27,7 +32,9 @@ void NRF24Receiver::configure(const Address *addr, RFChannel ch) {
   rf24.closeReadingPipe(1);
   rf24.setRadiation(RF24_PA_MIN, NRF24_DATA_RATE);
   rf24.setPayloadSize(PACKET_SIZE);
-  rf24.enableAckPayload();
+  rf24.setAutoAck(isAutoAck);
+  if (isAutoAck)
+    rf24.enableAckPayload();
   rf24.openReadingPipe(1, addr->address);
   rf24.setChannel(rfChannelToNRF24(ch));
   rf24.startListening();
@@ -81,6 +88,7 @@ RFChannel NRF24Receiver::getRFChannel() {
 }
 
 void NRF24Receiver::setRFChannel(RFChannel ch) {
+  rfChannel = ch;
   rf24.setChannel(rfChannelToNRF24(ch));
   PRINT(F("RF channel: "));
   PRINTLN(ch);
@@ -105,63 +113,49 @@ void NRF24Receiver::send(const ResponsePacket *packet) {
   rf24.writeAckPayload(1, packet, sizeof(ResponsePacket));
 }
 
-bool NRF24Receiver::pair() {
+void NRF24Receiver::enterPairing() {
   Address broadcast = ADDRESS_BROADCAST;
-  RequestPacket req;
-  ResponsePacket resp;
-  int readyCount = 0;
 
-  if (!isPaired()) {
+  // Keep address when re-pairing, so old transmitter settings still work
+  if (isPaired()) {
+    memcpy(&pairAddress, &address, sizeof(Address));
+  } else {
     randomSeed(millis());
     for (int i = 0; i < ADDRESS_LENGTH; i++)
-      address.address[i] = random(1 << 8);
+      pairAddress.address[i] = random(1 << 8);
   }
 
-  PRINTLN(F("NRF24: Starting pairing"));
   rf24.stopListening();
+  rf24.flush_tx();
   configure(&broadcast, DEFAULT_RF_CHANNEL);
+}
+
+// Payload goes out with the ack of the next INIT request
+void NRF24Receiver::sendPairReady(const PairPacket *request) {
+  ResponsePacket resp;
 
-  for (
-    unsigned long start = millis();
-    millis() - start < 10000;
-  ) {
-    if (rf24.available()) {
-      rf24.read(&req, sizeof(RequestPacket));
-
-      if (req.pair.packetType != PACKET_TYPE_PAIR) {
-        PRINTLN("NRF24: Ignoring non-pair type packet");
-        continue;
-      }
-
-      readyCount = 0;
-
-      if (req.pair.status == PAIR_STATUS_INIT) {
-        PRINT(F("NRF24: Ready to pair in session: "));
-        PRINTLN(req.pair.session);
-        resp.pair.packetType = PACKET_TYPE_PAIR;
-        resp.pair.status = PAIR_STATUS_READY;
-        resp.pair.session = req.pair.session;
-        memcpy(resp.pair.sender.address, address.address, ADDRESS_LENGTH);
-        readyCount = 10;
-      } else if (req.pair.status == PAIR_STATUS_PAIRED) {
-        PRINTLN(F("NRF24: Paired"));
-        rf24.stopListening();
-        configure(&address, DEFAULT_RF_CHANNEL);
-        return true;
-      }
-    } else {
-      delay(50);
-    }
-    if (readyCount) {
-      readyCount--;
-      PRINTLN("NRF24: Sending pair ready response");
-      rf24.writeAckPayload(1, &resp, sizeof(ResponsePacket));
-      delay(5);
-    }
-  };
-
-  PRINTLN(F("NRF24: Not paired"));
-  return false;
+  PRINT(F("NRF24: Ready to pair in session: "));
+  PRINTLN(request->session);
+  resp.pair.packetType = PACKET_TYPE_PAIR;
+  resp.pair.status = PAIR_STATUS_READY;
+  resp.pair.session = request->session;
+  memcpy(resp.pair.sender.address, pairAddress.address, ADDRESS_LENGTH);
+  rf24.writeAckPayload(1, &resp, sizeof(ResponsePacket));
+}
+
+void NRF24Receiver::leavePairing(bool isPaired) {
+  if (isPaired) {
+    memcpy(&address, &pairAddress, sizeof(Address));
+    rfChannel = DEFAULT_RF_CHANNEL;
+  }
+
+  rf24.stopListening();
+  rf24.flush_tx();
+  configure(&address, rfChannel);
+}
+
+void NRF24Receiver::setAutoAck(bool value) {
+  isAutoAck = value;
 }
 
 bool NRF24Receiver::isPaired() {
@@ -169,4 +163,24 @@ bool NRF24Receiver::isPaired() {
   return memcmp(address.address, noneAddr.address, ADDRESS_LENGTH);
 }
 
+bool NRF24Receiver::canScanRF() {
+  return true;
+}
+
+// Stays in RX mode, stopListening() would flush pending ack payloads.
+// Channel is switched in standby, with CE low.
+bool NRF24Receiver::isChannelBusy(RFChannel ch) {
+  bool isBusy;
+
+  digitalWrite(cePin, LOW);
+  rf24.setChannel(ch);
+  digitalWrite(cePin, HIGH);
+  delayMicroseconds(NRF24_RPD_TIME);
+  isBusy = rf24.testRPD();
+  digitalWrite(cePin, LOW);
+  rf24.setChannel(rfChannelToNRF24(rfChannel));
+  digitalWrite(cePin, HIGH);
+  return isBusy;
+}
+
 // vim:ai:sw=2:et
@@ -11,11 +11,18 @@
 class NRF24Receiver : public BaseReceiver {
   private:
     RF24 rf24;
-    Address address;
+    uint8_t cePin;
+    Address address,
+            pairAddress;
     RFChannel rfChannel;
+    bool isAutoAck;
 
     uint8_t rfChannelToNRF24(RFChannel ch);
     void configure(const Address *addr, RFChannel ch);
+  protected:
+    virtual void enterPairing();
+    virtual void sendPairReady(const PairPacket *request);
+    virtual void leavePairing(bool isPaired);
   public:
 
     NRF24Receiver(uint8_t cepin, uint8_t cspin);
@@ -27,8 +34,12 @@ class NRF24Receiver : public BaseReceiver {
     virtual void setPALevel(PALevel level);
     virtual bool receive(RequestPacket *packet);
     virtual void send(const ResponsePacket *packet);
-    virtual bool pair();
     virtual bool isPaired();
+    virtual bool canScanRF();
+    virtual bool isChannelBusy(RFChannel ch);
+    // Disable for secondary radios of diversity receiver, so only one
+    // radio acknowledges. Call before begin().
+    void setAutoAck(bool value);
 };
 
 #endif // LOWCOSTRC_RX_NRF24_H
@@ -31,9 +31,17 @@
 // R2 resistor value in Ohm's (minus side)
 #define VOLT_METER_R2 10000L
 
-// Use PWMDutyCycleOutput to take 0..100% duty cycle range on output. Suitable
-// to control brushed motor in one direction
-PWMDutyCycleOutput channel1Output(CHANNEL1_PIN);
+// PWM frequency for brushed motor in Hz
+#define MOTOR_FREQUENCY 20000
+
+// Throttle expo in percents (0 is linear)
+#define MOTOR_EXPO 0
+
+// Use PWMMotorOutput to take 0..100% duty cycle range on output with high PWM
+// frequency, it writes timer registers directly. Suitable to control brushed
+// motor in one direction. Use DirectPWMDutyCycleOutput (or PWMDutyCycleOutput
+// with analogWrite()) for default PWM frequency
+PWMMotorOutput channel1Output(CHANNEL1_PIN, MOTOR_FREQUENCY, MOTOR_EXPO);
 
 // Use PWMMicrosecondsOutput to take exactly impulse width in microseconds that
 // corresponds received value (1000..2000 by default). Suitable to control
@@ -53,10 +61,27 @@ NRF24Receiver receiver(RADIO_CE_PIN, RADIO_CSN_PIN);
 VoltMetter voltMetter(VOLT_METER_PIN, VOLT_METER_R1, VOLT_METER_R2);
 RxController controller(&settings, &receiver, outputs, &voltMetter, PAIR_PIN);
 
+#ifdef WITH_STABILIZER
+// MPU6050 gyro connected to A4 (SDA) and A5 (SCL). Keep the model still for
+// a few seconds after power on, while gyro is calibrated.
+Stabilizer stabilizer;
+
+// Channel that enables stabilization, 1000 is off and 2000 is full gain
+#define STABILIZER_GAIN_CHANNEL CHANNEL5
+#endif
+
 void setup(void) {
   #ifdef WITH_CONSOLE
   Serial.begin(115200);
   #endif
+#ifdef WITH_STABILIZER
+  stabilizer.axes[0].channel = CHANNEL2;
+  stabilizer.axes[0].gyroAxis = GYRO_AXIS_X;
+  stabilizer.axes[1].channel = CHANNEL3;
+  stabilizer.axes[1].gyroAxis = GYRO_AXIS_Y;
+  stabilizer.gainChannel = STABILIZER_GAIN_CHANNEL;
+  controller.setStabilizer(&stabilizer);
+#endif
   controller.begin();
 }
 
@@ -1,6 +1,7 @@
 #include <LowcostRC_Rx_nRF24.h>
 #include <LowcostRC_Rx_Controller.h>
 #include <LowcostRC_Output.h>
+#include <LowcostRC_Pulse_Output.h>
 #include <LowcostRC_VoltMetter.h>
 
 // Pin that connected to the bind button
@@ -30,12 +31,23 @@
 // R2 resistor value in Ohm's (minus side)
 #define VOLT_METER_R2 10000L
 
+#ifdef WITH_ONESHOT125
+// Use PulseOutput to generate pulses right after control frame is received.
+// PULSE_MODE_ONESHOT125 takes 125..250us impulse width for ESC that support
+// OneShot125 protocol. Use PULSE_MODE_SERVO_333HZ for digital servos and
+// PULSE_MODE_SERVO_50HZ for analog ones. Don't mix PulseOutput and
+// PWMMicrosecondsOutput, both use Timer1.
+PulseOutput channel1Output(CHANNEL1_PIN, PULSE_MODE_ONESHOT125),
+            channel2Output(CHANNEL2_PIN, PULSE_MODE_SERVO_50HZ),
+            channel3Output(CHANNEL3_PIN, PULSE_MODE_SERVO_50HZ);
+#else
 // Use PWMMicrosecondsOutput to take exactly impulse width in microseconds that
 // corresponds received value (1000..2000 by default). Suitable to control
 // servo motors or ESCs.
 PWMMicrosecondsOutput channel1Output(CHANNEL1_PIN),
                       channel2Output(CHANNEL2_PIN),
                       channel3Output(CHANNEL3_PIN);
+#endif
 
 BaseOutput *outputs[] = {
   &channel1Output,
@@ -49,10 +61,27 @@ NRF24Receiver receiver(RADIO_CE_PIN, RADIO_CSN_PIN);
 VoltMetter voltMetter(VOLT_METER_PIN, VOLT_METER_R1, VOLT_METER_R2);
 RxController controller(&settings, &receiver, outputs, &voltMetter, PAIR_PIN);
 
+#ifdef WITH_STABILIZER
+// MPU6050 gyro connected to A4 (SDA) and A5 (SCL). Keep the model still for
+// a few seconds after power on, while gyro is calibrated.
+Stabilizer stabilizer;
+
+// Channel that enables stabilization, 1000 is off and 2000 is full gain
+#define STABILIZER_GAIN_CHANNEL CHANNEL5
+#endif
+
 void setup(void) {
   #ifdef WITH_CONSOLE
   Serial.begin(115200);
   #endif
+#ifdef WITH_STABILIZER
+  stabilizer.axes[0].channel = CHANNEL2;
+  stabilizer.axes[0].gyroAxis = GYRO_AXIS_X;
+  stabilizer.axes[1].channel = CHANNEL3;
+  stabilizer.axes[1].gyroAxis = GYRO_AXIS_Y;
+  stabilizer.gainChannel = STABILIZER_GAIN_CHANNEL;
+  controller.setStabilizer(&stabilizer);
+#endif
   controller.begin();
 }
 
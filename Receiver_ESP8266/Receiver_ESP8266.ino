@@ -1,4 +1,8 @@
 #include <LowcostRC_Rx_ESP8266.h>
+#ifdef WITH_DIVERSITY
+#include <LowcostRC_Rx_nRF24.h>
+#include <LowcostRC_Rx_Diversity.h>
+#endif
 #include <LowcostRC_Rx_Controller.h>
 #include <LowcostRC_Rx_Settings.h>
 #include <LowcostRC_Output.h>
@@ -10,11 +14,25 @@
 // Pin that connected to the MOSFET gate that controls a brushed motor(s)
 #define CHANNEL1_PIN 4
 
+#ifdef WITH_DIVERSITY
+// nRF24L01 as second radio, it takes SPI pins 12, 13 and 14. CSN is a boot
+// strap pin, it needs a pull-down resistor.
+#define RADIO_CE_PIN 16
+#define RADIO_CSN_PIN 15
+
+// Pin that connected to the alerons servo
+#define CHANNEL2_PIN 5
+
+// Pin that connected to that elevator servo, serial RX is the only free
+// pin left, console works in TX only mode
+#define CHANNEL3_PIN 3
+#else
 // Pin that connected to the alerons servo
 #define CHANNEL2_PIN 12
 
 // Pin that connected to that elevator servo
 #define CHANNEL3_PIN 14
+#endif
 
 // Pin that connected to the resistor divider to measure battery voltage
 #define VOLT_METER_PIN A0
@@ -25,9 +43,16 @@
 // R2 resistor value in Ohm's (minus side)
 #define VOLT_METER_R2 10000L
 
-// Use PWMDutyCycleOutput to take 0..100% duty cycle range on output. Suitable
-// to control brushed motor in one direction
-PWMDutyCycleOutput channel1Output(CHANNEL1_PIN);
+// PWM frequency for brushed motor in Hz
+#define MOTOR_FREQUENCY 20000
+
+// Throttle expo in percents (0 is linear)
+#define MOTOR_EXPO 0
+
+// Use PWMMotorOutput to take 0..100% duty cycle range on output with high PWM
+// frequency. Suitable to control brushed motor in one direction. Use
+// PWMDutyCycleOutput for default analogWrite() frequency
+PWMMotorOutput channel1Output(CHANNEL1_PIN, MOTOR_FREQUENCY, MOTOR_EXPO);
 
 // Use PWMMicrosecondsOutput to take exactly impulse width in microseconds that
 // corresponds received value (1000..2000 by default). Suitable to control
@@ -43,15 +68,39 @@ BaseOutput *outputs[] = {
 };
 
 EEPROMRxSettings settings;
+#ifdef WITH_DIVERSITY
+// ESP-NOW is primary, it pairs and sends responses. nRF24 path takes its
+// address and gets the frames of transmitter built WITH_DUAL_RADIO.
+ESP8266Receiver espReceiver;
+NRF24Receiver nrf24Receiver(RADIO_CE_PIN, RADIO_CSN_PIN);
+BaseReceiver *paths[] = {
+  &espReceiver,
+  &nrf24Receiver,
+  NULL
+};
+DiversityReceiver receiver(paths);
+PathQualitySensor espQuality(&receiver, 0),
+                  nrf24Quality(&receiver, 1);
+#else
 ESP8266Receiver receiver;
+#endif
 VoltMetter voltMetter(VOLT_METER_PIN, VOLT_METER_R1, VOLT_METER_R2);
 RxController controller(&settings, &receiver, outputs, &voltMetter, PAIR_PIN, LED_BUILTIN);
 
 void setup() {
 #ifdef WITH_CONSOLE
+#ifdef WITH_DIVERSITY
+  Serial.begin(115200, SERIAL_8N1, SERIAL_TX_ONLY);
+#else
   Serial.begin(115200);
 #endif
+#endif
 
+#ifdef WITH_DIVERSITY
+  nrf24Receiver.setAutoAck(false);
+  controller.addSensor(&espQuality);
+  controller.addSensor(&nrf24Quality);
+#endif
   controller.setLedInverted(true);
   controller.begin();
 }
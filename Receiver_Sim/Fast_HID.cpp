@@ -0,0 +1,110 @@
+#include <string.h>
+#include <HID.h>
+#include "Fast_HID.h"
+
+// 16 bit value per axis, logical range matches channel values
+static const uint8_t reportDescriptor[] PROGMEM = {
+  0x05, 0x01,                    // Usage Page (Generic Desktop)
+  0x09, 0x04,                    // Usage (Joystick)
+  0xa1, 0x01,                    // Collection (Application)
+  0x85, FAST_HID_REPORT_ID,      //   Report ID
+  0x16, 0xe8, 0x03,              //   Logical Minimum (1000)
+  0x26, 0xd0, 0x07,              //   Logical Maximum (2000)
+  0x75, 0x10,                    //   Report Size (16)
+  0xa1, 0x00,                    //   Collection (Physical)
+  0x09, 0x30,                    //     Usage (X)
+  0x09, 0x31,                    //     Usage (Y)
+  0x09, 0x32,                    //     Usage (Z)
+  0x09, 0x33,                    //     Usage (Rx)
+  0x09, 0x34,                    //     Usage (Ry)
+  0x09, 0x35,                    //     Usage (Rz)
+  0x95, 0x06,                    //     Report Count (6)
+  0x81, 0x02,                    //     Input (Data, Variable, Absolute)
+  0x05, 0x02,                    //     Usage Page (Simulation Controls)
+  0x09, 0xba,                    //     Usage (Rudder)
+  0x09, 0xbb,                    //     Usage (Throttle)
+  0x95, 0x02,                    //     Report Count (2)
+  0x81, 0x02,                    //     Input (Data, Variable, Absolute)
+  0xc0,                          //   End Collection
+  0xc0,                          // End Collection
+};
+
+// Report axis for every channel, same layout as the Joystick library setup
+static const uint8_t channelAxes[NUM_CHANNELS] = {
+  2, // CHANNEL1: Z
+  3, // CHANNEL2: Rx
+  0, // CHANNEL3: X
+  1, // CHANNEL4: Y
+  4, // CHANNEL5: Ry
+  5, // CHANNEL6: Rz
+  6, // CHANNEL7: Rudder
+  7, // CHANNEL8: Throttle
+};
+
+static uint8_t getUSBFrame() {
+  return UDFNUML;
+}
+
+FastHID::FastHID()
+  : packetTime(0),
+    sentFrame(0),
+    isPending(false)
+{
+  memset(&report, 0, sizeof(report));
+  memset(&sentReport, 0, sizeof(sentReport));
+
+  static HIDSubDescriptor node(reportDescriptor, sizeof(reportDescriptor));
+  HID().AppendDescriptor(&node);
+}
+
+void FastHID::write(const ControlPacket *control, unsigned long packetTime) {
+  for (uint8_t i = 0; i < NUM_CHANNELS; i++)
+    report.axes[channelAxes[i]] = constrain(
+      control->channels[i], FAST_HID_AXIS_MIN, FAST_HID_AXIS_MAX
+    );
+
+  if (memcmp(&report, &sentReport, sizeof(report)) == 0) {
+    isPending = false;
+    return;
+  }
+
+  // Latency counts from the oldest unsent change
+  if (!isPending) this->packetTime = packetTime;
+  isPending = true;
+  send();
+}
+
+void FastHID::handle() {
+  if (isPending) send();
+}
+
+bool FastHID::send() {
+  uint8_t frame = getUSBFrame();
+
+  // Previous report may still wait for the host poll in this frame
+  if (frame == sentFrame) return false;
+
+  HID().SendReport(FAST_HID_REPORT_ID, &report, sizeof(report));
+  memcpy(&sentReport, &report, sizeof(report));
+  sentFrame = frame;
+  isPending = false;
+  latency.add(micros() - packetTime);
+  return true;
+}
+
+FastHIDLatencySensor::FastHIDLatencySensor(FastHID *hid)
+  : BaseSensor(1000, 10),
+    hid(hid)
+{
+}
+
+void FastHIDLatencySensor::sample() {
+  value = min(hid->latency.getAverage(), 0x7fffUL);
+  hid->latency.reset();
+}
+
+SensorType FastHIDLatencySensor::getType() {
+  return SENSOR_TYPE_LATENCY;
+}
+
+// vim:ai:sw=2:et
@@ -0,0 +1,53 @@
+#ifndef Fast_HID_h
+#define Fast_HID_h
+
+#include <LowcostRC_Protocol.h>
+#include <LowcostRC_Stats.h>
+#include <LowcostRC_Sensor.h>
+
+#define FAST_HID_REPORT_ID 3
+#define FAST_HID_AXIS_MIN 1000
+#define FAST_HID_AXIS_MAX 2000
+
+// Axes in HID usage order: X, Y, Z, Rx, Ry, Rz, Rudder, Throttle
+struct FastHIDReport {
+  uint16_t axes[NUM_CHANNELS];
+} __attribute__((__packed__));
+
+// Joystick with a fixed report packed straight from channels. Reports are
+// sent only on change, at most once per USB frame, so sending never waits
+// for the host to poll the previous report.
+class FastHID {
+  private:
+    FastHIDReport report,
+                  sentReport;
+    unsigned long packetTime;
+    uint8_t sentFrame;
+    bool isPending;
+
+    bool send();
+  public:
+    // Packet received to report handed to USB, us
+    TimingStats latency;
+
+    // Report descriptor is added here, before USB enumeration, so the
+    // object must be global
+    FastHID();
+    // packetTime is RxController::packetTime
+    void write(const ControlPacket *control, unsigned long packetTime);
+    // Sends report deferred to the next USB frame
+    void handle();
+};
+
+// Reports average FastHID latency in telemetry
+class FastHIDLatencySensor : public BaseSensor {
+  private:
+    FastHID *hid;
+  public:
+    FastHIDLatencySensor(FastHID *hid);
+    virtual void sample();
+    virtual SensorType getType();
+};
+
+#endif // Fast_HID_h
+// vim:ai:sw=2:et
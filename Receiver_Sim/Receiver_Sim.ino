@@ -1,15 +1,44 @@
+#ifndef WITH_FAST_HID
 #include <Joystick.h>
+#endif
 
 #include <LowcostRC_Protocol.h>
 #include <LowcostRC_Rx_Settings.h>
 #include <LowcostRC_Rx_nRF24.h>
 #include <LowcostRC_Rx_Controller.h>
 
+#ifdef WITH_FAST_HID
+#include "Fast_HID.h"
+#endif
+
 #define PAIR_PIN 2
 
 #define RADIO_CE_PIN 9
 #define RADIO_CSN_PIN 10
 
+#ifdef WITH_FAST_HID
+class SimRxController : public RxController {
+  public:
+    FastHID hid;
+    FastHIDLatencySensor latencySensor;
+
+    SimRxController(BaseRxSettings *settings, BaseReceiver *receiver, int pairPin)
+      : RxController(settings, receiver, NULL, NULL, pairPin, -1)
+      , latencySensor(&hid)
+    {
+      addSensor(&latencySensor);
+    }
+
+    virtual void handle() {
+      RxController::handle();
+      hid.handle();
+    }
+
+    virtual void applyControl(const ControlPacket *control) {
+      hid.write(control, packetTime);
+    }
+};
+#else
 class SimRxController : public RxController {
   public:
     Joystick_ Joystick;
@@ -62,6 +91,7 @@ class SimRxController : public RxController {
       Joystick.sendState();
     }
 };
+#endif
 
 EEPROMRxSettings settings;
 NRF24Receiver receiver(RADIO_CE_PIN, RADIO_CSN_PIN);
@@ -0,0 +1,71 @@
+#ifndef Axis_Table_h
+#define Axis_Table_h
+
+#include <stdint.h>
+
+// Axis transfer function: dead band bounds and outer segment slopes in
+// fine ADC units, so a sample maps without division. Kept free of Arduino
+// headers, tools/axis_table_check.cpp builds it on the host.
+struct AxisTable {
+  bool invert;
+  int centerPulse;
+  uint16_t dualRate;
+  long low, high;
+  // dualRate / segment span, 16 fractional bits
+  uint32_t lowSlope, highSlope;
+};
+
+// Center and threshold are in fine units, fineMax is the full scale value
+static inline void compileAxisTable(
+  AxisTable *t,
+  long center,
+  long threshold,
+  bool invert,
+  uint16_t dualRate,
+  int centerPulse,
+  long fineMax
+) {
+  t->invert = invert;
+  if (invert) center = fineMax - center;
+  t->centerPulse = centerPulse;
+  t->dualRate = dualRate;
+  t->low = center - threshold;
+  t->high = center + threshold;
+  // Segments that samples can't reach get no slope
+  t->lowSlope = (t->low > 0) ?
+    ((uint32_t)dualRate << 16) / t->low : 0;
+  t->highSlope = (fineMax - t->high > 0) ?
+    ((uint32_t)dualRate << 16) / (fineMax - t->high) : 0;
+}
+
+// Same result as map() over the segment: the 16 bit slope can only
+// undershoot the exact quotient by one, which a multiply corrects
+static inline uint16_t scaleSegment(uint32_t offset, uint32_t span, uint16_t dualRate, uint32_t slope) {
+  uint16_t result = (offset * slope) >> 16;
+
+  if ((uint32_t)(result + 1) * span <= offset * dualRate) result++;
+  return result;
+}
+
+// Pulse width for a fine sample, limited to 0..5000
+static inline int mapAxisTable(const AxisTable *t, long value, long fineMax) {
+  int pulse;
+
+  if (t->invert) value = fineMax - value;
+
+  if (value < t->low)
+    pulse = t->centerPulse - t->dualRate
+      + scaleSegment(value, t->low, t->dualRate, t->lowSlope);
+  else if (value > t->high)
+    pulse = t->centerPulse
+      + scaleSegment(value - t->high, fineMax - t->high, t->dualRate, t->highSlope);
+  else
+    pulse = t->centerPulse;
+
+  if (pulse < 0) return 0;
+  if (pulse > 5000) return 5000;
+  return pulse;
+}
+
+#endif // Axis_Table_h
+// vim:ai:sw=2:et
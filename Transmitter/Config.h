@@ -21,6 +21,22 @@
 #define RADIO_NRF24_CE_PIN  9
 #define RADIO_NRF24_CSN_PIN 10
 
+#ifdef WITH_DUAL_RADIO
+// Both modules share SPI bus, the serial TX line is the only free pin
+// left to select the ESP8266 bridge. The bridge is deselected with SS
+// HIGH, which is its GPIO15 boot strap pin: the bridge must boot before
+// the transmitter drives SS, and must not be reset on its own.
+#define RADIO_SPI_SS_PIN    1
+#if !defined(WITH_RADIO_NRF24) || !defined(WITH_RADIO_SPI)
+#error "WITH_DUAL_RADIO needs both WITH_RADIO_NRF24 and WITH_RADIO_SPI"
+#endif
+#ifdef WITH_CONSOLE
+#error "WITH_DUAL_RADIO uses serial TX pin, WITH_CONSOLE is not available"
+#endif
+#else
+#define RADIO_SPI_SS_PIN    10
+#endif
+
 #define DISPLAY_WIDTH       128
 #define DISPLAY_HEIGHT      64
 #define DISPLAY_ADDRESS     0x3C
@@ -37,6 +53,25 @@
 #define BATTERY_MONITOR_INTERVAL 5000
 #define SCREEN_DISPLAY_REDRAW_INTERVAL 1000
 
+// Scheduler task periods, microseconds
+#define CONTROLS_TASK_PERIOD 4000
+#define RADIO_TASK_PERIOD    4000
+#define BUZZER_TASK_PERIOD   4000
+#define UI_TASK_PERIOD       4000
+
+// Expected task run times, microseconds. Tasks lower in priority than
+// controls only start in its idle time, so all of them have to fit in
+// one controls period. Radio task sends the control frame: nRF24 at
+// 250kbps takes about 2ms for a packet with ack payload.
+#define CONTROLS_TASK_BUDGET 400
+#define RADIO_TASK_BUDGET    2600
+#define BUZZER_TASK_BUDGET   100
+#define UI_TASK_BUDGET       800
+
+#if CONTROLS_TASK_BUDGET + RADIO_TASK_BUDGET + BUZZER_TASK_BUDGET + UI_TASK_BUDGET > CONTROLS_TASK_PERIOD
+#error "Task budgets do not fit in CONTROLS_TASK_PERIOD"
+#endif
+
 //undef FLAT_MENU
 
 #endif // Config_h
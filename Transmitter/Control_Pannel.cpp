@@ -10,10 +10,33 @@
 #define SWITCH_MIN        0
 #define SWITCH_MAX     3000
 
+#define PROGRESS_REDRAW_INTERVAL 100
+
+// Fields of a mix line screen, the cursor steps through them when idle
+#define MIX_LINE_FIELDS 6
+#define MIX_CURSOR_INTERVAL 3000
+
+// Scan graph columns, one character each in small font
+#define RF_SCAN_COLUMNS 21
+#define RF_SCAN_COLUMN_CHANNELS ((RF_SCAN_CHANNELS + RF_SCAN_COLUMNS - 1) / RF_SCAN_COLUMNS)
+
 #define FLAG_SETTINGS_LONG_PRESS 0
 #define FLAG_IS_PAIRING          1
 #define FLAG_CURSOR_MOVE         2
 #define FLAG_CURSOR_BLINK        3
+#define FLAG_RF_SCANNING         4
+#define FLAG_RF_SCAN_RESULT      5
+
+#define IS_MIXER_SCREEN(screen) ((screen) >= SCREEN_MIX_1 && (screen) <= SCREEN_CURVE_2)
+
+#ifdef WITH_RF_SCAN
+#define IS_SMALL_FONT_SCREEN(screen) ((screen) == SCREEN_RF_SCAN || IS_MIXER_SCREEN(screen))
+#else
+#define IS_SMALL_FONT_SCREEN(screen) IS_MIXER_SCREEN(screen)
+#endif
+
+// Levels of text graphs
+const char graphLevels[] PROGMEM = " .:-=+*#";
 
 #ifndef FLAT_MENU
 const Screen radioMenu[] = {
@@ -21,6 +44,9 @@ const Screen radioMenu[] = {
   SCREEN_PEER_ADDR,
   SCREEN_RF_CHANNEL,
   SCREEN_PA_LEVEL,
+#ifdef WITH_RF_SCAN
+  SCREEN_RF_SCAN,
+#endif
   SCREEN_MENU_UP,
   SCREEN_NULL
 };
@@ -64,6 +90,17 @@ const Screen mappingMenu[] = {
   SCREEN_NULL
 };
 
+const Screen mixerMenu[] = {
+  SCREEN_MIX_1,
+  SCREEN_MIX_2,
+  SCREEN_MIX_3,
+  SCREEN_MIX_4,
+  SCREEN_CURVE_1,
+  SCREEN_CURVE_2,
+  SCREEN_MENU_UP,
+  SCREEN_NULL
+};
+
 const Screen peerMenu[] = {
   SCREEN_BATTERY_LOW,
   SCREEN_SAVE_FAILSAFE,
@@ -74,11 +111,13 @@ const Screen peerMenu[] = {
 const Screen mainMenu[] = {
   SCREEN_BLANK,
   SCREEN_DISPLAY,
+  SCREEN_TIMING,
   SCREEN_PROFILE,
   SCREEN_PROFILE_NAME,
   SCREEN_GROUP_RADIO,
   SCREEN_GROUP_CONTROLS,
   SCREEN_GROUP_MAPPING,
+  SCREEN_GROUP_MIXER,
   SCREEN_GROUP_PEER,
   SCREEN_SAVE,
   SCREEN_NULL
@@ -91,12 +130,31 @@ struct SubMenu {
   {SCREEN_GROUP_RADIO, radioMenu},
   {SCREEN_GROUP_CONTROLS, controlsMenu},
   {SCREEN_GROUP_MAPPING, mappingMenu},
+  {SCREEN_GROUP_MIXER, mixerMenu},
   {SCREEN_GROUP_PEER, peerMenu},
 };
 #endif
 
 #define addWithConstrain(value, delta, lo, hi) value = constrain((long)value + (delta), lo, hi)
 
+// Puts the cursor mark at the start of a text line
+static void markLine(char *text, int line) {
+  while (line > 0 && *text) {
+    if (*text++ == '\n') line--;
+  }
+  if (*text) *text = '>';
+}
+
+// Timing histogram as one graph character per bucket, any value visible
+static char *printHistogram(char *text, TimingStats *stats) {
+  for (uint8_t i = 0; i < TIMING_STATS_BUCKETS; i++) {
+    uint8_t level = (stats->getBucketShare(i) * 7 + 254) / 255;
+    *text++ = pgm_read_byte(&graphLevels[level]);
+  }
+  *text = 0;
+  return text;
+}
+
 ControlPannel::ControlPannel(
   Settings *settings, Buzzer *buzzer, RadioControl *radioControl, Controls *controls
 )
@@ -104,11 +162,6 @@ ControlPannel::ControlPannel(
   , buzzer(buzzer)
   , radioControl(radioControl)
   , controls(controls)
-#if defined(WITH_ADAFRUIT_SSD1306)
-  , display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1)
-#elif defined(WITH_SSD1306_ASCII)
-  , display()
-#endif
   , screenButton(KEY_SCREEN_PIN)
   , plusButton(KEY_PLUS_PIN)
   , minusButton(KEY_MINUS_PIN)
@@ -118,6 +171,7 @@ ControlPannel::ControlPannel(
 }
 
 void ControlPannel::begin() {
+  voltMetter.begin();
   screenButton.begin();
   screenButton.setDebounceTime(20);
   plusButton.begin();
@@ -125,33 +179,27 @@ void ControlPannel::begin() {
   minusButton.begin();
   minusButton.setDebounceTime(20);
 
-#if defined(WITH_ADAFRUIT_SSD1306)
-  if (!display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS)) {
-    PRINTLN(F("SSD1306 init FAIL"));
-  } else {
-    PRINTLN(F("SSD1306 init OK"));
-  };
-  display.clearDisplay();
-  display.display();
-#elif defined(WITH_SSD1306_ASCII)
-  Wire.begin();
-  Wire.setClock(400000L);
-  display.begin(&Adafruit128x64, DISPLAY_ADDRESS);
-  display.setFont(System5x7);
-  display.clear();
-#endif
+  display.begin();
 
-  radioControl->radio->setPeer(&settings->values.peer);
-  radioControl->radio->setRFChannel(settings->values.rfChannel);
+  radioControl->setPeer(&settings->values.peer);
+  radioControl->setRFChannel(settings->values.rfChannel);
+  controls->updateTables();
 }
 
 void ControlPannel::redrawScreen() {
-  char text[50] = "",
+  char text[96] = "",
        yStr[] = "y",
        nStr[] = "n",
-       axisNames[][3] = {"AX", "AY", "BX", "BY"};
+       axisNames[][3] = {"AX", "AY", "BX", "BY"},
+       source[4], destination[4], curve[5], condition[4];
   Axis axis;
   Switch sw;
+  MixLine *mixLine;
+  int8_t *points;
+  size_t len;
+#ifdef WITH_RF_SCAN
+  uint8_t level;
+#endif
 
   switch (currentScreen) {
     case SCREEN_BLANK:
@@ -171,6 +219,42 @@ void ControlPannel::redrawScreen() {
         (radioControl->telemetry.batteryMV % 1000) / 10,
         radioControl->linkQuality
       );
+#ifdef WITH_DUAL_RADIO
+      if (radioControl->secondary) {
+        sprintf_P(
+          text + strlen(text),
+          PSTR(" %d/%d"),
+          radioControl->pathQuality[0],
+          radioControl->pathQuality[1]
+        );
+      }
+#endif
+      sprintf_P(
+        text + strlen(text),
+        PSTR("\nRTT: %u.%ums %upps"),
+        (unsigned int)(radioControl->rtt / 1000),
+        (unsigned int)(radioControl->rtt % 1000 / 100),
+        radioControl->packetRate
+      );
+      break;
+    case SCREEN_TIMING:
+      // Microseconds, min/avg/max and histogram from <32 to >=2048
+      len = sprintf_P(
+        text,
+        PSTR("Lat %u/%u/%u\n"),
+        (unsigned int)min(radioControl->latencyStats.minValue, 0xffffUL),
+        (unsigned int)min(radioControl->latencyStats.getAverage(), 0xffffUL),
+        (unsigned int)min(radioControl->latencyStats.maxValue, 0xffffUL)
+      );
+      len = printHistogram(text + len, &radioControl->latencyStats) - text;
+      len += sprintf_P(
+        text + len,
+        PSTR("\nJit %u/%u/%u\n"),
+        (unsigned int)min(controls->loopStats.minValue, 0xffffUL),
+        (unsigned int)min(controls->loopStats.getAverage(), 0xffffUL),
+        (unsigned int)min(controls->loopStats.maxValue, 0xffffUL)
+      );
+      printHistogram(text + len, &controls->loopStats);
       break;
     case SCREEN_PROFILE:
       sprintf_P(
@@ -193,7 +277,8 @@ void ControlPannel::redrawScreen() {
       if (bitRead(flags, FLAG_IS_PAIRING)) {
         sprintf_P(
           text,
-          PSTR("Pairing...")
+          PSTR("Pairing\n%d%%"),
+          radioControl->getPairingProgress()
         );
       } else {
         sprintf_P(
@@ -232,6 +317,32 @@ void ControlPannel::redrawScreen() {
         settings->values.paLevel + 1
       );
       break;
+#ifdef WITH_RF_SCAN
+    case SCREEN_RF_SCAN:
+      if (!radioControl->canScanRF()) {
+        sprintf_P(text, PSTR("RF scan\nn/a"));
+        break;
+      }
+      strcpy_P(text, PSTR("RF scan\n"));
+      len = strlen(text);
+      for (int i = 0; i < RF_SCAN_COLUMNS; i++) {
+        level = radioControl->rfScan.getMaxHits(
+          i * RF_SCAN_COLUMN_CHANNELS, RF_SCAN_COLUMN_CHANNELS
+        );
+        // Any hit is visible, transmitter and receiver sweeps at full scale
+        level = min((level * 7 + 2 * RF_SCAN_SWEEPS - 1) / (2 * RF_SCAN_SWEEPS), 7);
+        text[len++] = pgm_read_byte(&graphLevels[level]);
+      }
+      text[len] = 0;
+      if (radioControl->rfScan.isRunning()) {
+        sprintf_P(text + len, PSTR("\nScanning %d%%"), radioControl->rfScan.getProgress());
+      } else if (bitRead(flags, FLAG_RF_SCAN_RESULT)) {
+        sprintf_P(text + len, PSTR("\nBest: %d"), radioControl->rfScan.getQuietest());
+      } else {
+        sprintf_P(text + len, PSTR("\nChannel: %d"), settings->values.rfChannel);
+      }
+      break;
+#endif
     case SCREEN_AUTO_CENTER:
       sprintf_P(
         text,
@@ -342,6 +453,58 @@ void ControlPannel::redrawScreen() {
         );
       }
       break;
+    case SCREEN_MIX_1:
+    case SCREEN_MIX_2:
+    case SCREEN_MIX_3:
+    case SCREEN_MIX_4:
+      mixLine = &settings->values.mixLines[currentScreen - SCREEN_MIX_1];
+      if (mixLine->source < AXES_COUNT)
+        strcpy(source, axisNames[mixLine->source]);
+      else
+        sprintf_P(source, PSTR("S%d"), mixLine->source - MIX_SOURCE_SWITCH_1 + 1);
+      if (mixLine->destination != NO_CHANNEL)
+        sprintf_P(destination, PSTR("%d"), mixLine->destination + 1);
+      else
+        strcpy_P(destination, PSTR("-"));
+      if (mixLine->curve > 0)
+        sprintf_P(curve, PSTR("E%d"), mixLine->curve);
+      else if (mixLine->curve < 0)
+        sprintf_P(curve, PSTR("C%d"), -mixLine->curve);
+      else
+        strcpy_P(curve, PSTR("Lin"));
+      if (mixLine->condition != 0)
+        sprintf_P(
+          condition, PSTR("%d%c"),
+          abs(mixLine->condition), mixLine->condition > 0 ? 'H' : 'L'
+        );
+      else
+        strcpy_P(condition, PSTR("-"));
+      sprintf_P(
+        text,
+        PSTR("Mix %d\n Src %s\n Dst %s\n Crv %s\n Wgt %d\n Ofs %d\n Sw  %s"),
+        currentScreen - SCREEN_MIX_1 + 1,
+        source,
+        destination,
+        curve,
+        mixLine->weight,
+        mixLine->offset,
+        condition
+      );
+      if (bitRead(flags, FLAG_CURSOR_BLINK))
+        markLine(text, cursor + 1);
+      break;
+    case SCREEN_CURVE_1:
+    case SCREEN_CURVE_2:
+      points = settings->values.curves[currentScreen - SCREEN_CURVE_1];
+      sprintf_P(
+        text,
+        PSTR("Curve %d\n P1 %d\n P2 %d\n P3 %d\n P4 %d\n P5 %d"),
+        currentScreen - SCREEN_CURVE_1 + 1,
+        points[0], points[1], points[2], points[3], points[4]
+      );
+      if (bitRead(flags, FLAG_CURSOR_BLINK))
+        markLine(text, cursor + 1);
+      break;
     case SCREEN_BATTERY_LOW:
       sprintf_P(
         text,
@@ -381,6 +544,12 @@ void ControlPannel::redrawScreen() {
         PSTR("Mapping>")
       );
       break;
+    case SCREEN_GROUP_MIXER:
+      sprintf_P(
+        text,
+        PSTR("Mixer>")
+      );
+      break;
     case SCREEN_GROUP_PEER:
       sprintf_P(
         text,
@@ -396,26 +565,12 @@ void ControlPannel::redrawScreen() {
 #endif
   }
 
-#if defined(WITH_ADAFRUIT_SSD1306)
-  display.fillRect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, BLACK);
-  if (currentScreen == SCREEN_DISPLAY) {
-    display.setTextSize(1);
-  } else {
-    display.setTextSize(2);
-  }
-  display.setTextColor(WHITE);
-  display.setCursor(0, 0);
-  display.println(text);
-  display.display();
-#elif defined(WITH_SSD1306_ASCII)
-  if (currentScreen == SCREEN_DISPLAY) {
-    display.set1X();
-  } else {
-    display.set2X();
-  }
-  display.clear();
-  display.print(text);
-#endif
+  display.draw(
+    text,
+    currentScreen == SCREEN_DISPLAY
+    || currentScreen == SCREEN_TIMING
+    || IS_SMALL_FONT_SCREEN(currentScreen)
+  );
   redrawTime = millis();
 }
 
@@ -488,9 +643,11 @@ void ControlPannel::handle() {
   int change = 0;
   Axis axis;
   Switch sw;
+  MixLine *mixLine;
   Screen prevScreen = currentScreen;
   bool needsRedraw = false;
   unsigned long now = millis();
+  TIMING_START(handleStart);
 
   screenButton.handle();
   plusButton.handle();
@@ -512,6 +669,8 @@ void ControlPannel::handle() {
   if (currentScreen != prevScreen) {
     PRINT(F("Screen: "));
     PRINTLN(currentScreen);
+    cursor = 0;
+    settingsChangeTime = now;
     redrawScreen();
   }
 
@@ -544,8 +703,8 @@ void ControlPannel::handle() {
           settings->currentProfile, change, 0, NUM_PROFILES - 1
         );
         settings->loadProfile();
-        radioControl->radio->setPeer(&settings->values.peer);
-        radioControl->radio->setRFChannel(settings->values.rfChannel);
+        radioControl->setPeer(&settings->values.peer);
+        radioControl->setRFChannel(settings->values.rfChannel);
         break;
       case SCREEN_PROFILE_NAME:
         if (change) {
@@ -556,24 +715,12 @@ void ControlPannel::handle() {
         }
         break;
       case SCREEN_BIND_PEER:
+        if (radioControl->isPairing()) break;
         if (change > 0) {
           bitSet(flags, FLAG_IS_PAIRING);
-          redrawScreen();
-          if (radioControl->radio->pair()) {
-            memcpy(
-              settings->values.peer.address,
-              radioControl->radio->peer.address,
-              ADDRESS_LENGTH
-            );
-            buzzer->beep(BEEP_LOW_HZ, 30, 30, 1);
-            settings->values.rfChannel = DEFAULT_RF_CHANNEL;
-          } else {
-            buzzer->beep(BEEP_HIGH_HZ, 5, 30, 5);
-          }
-          bitClear(flags, FLAG_IS_PAIRING);
-          needsRedraw = true;
+          radioControl->startPairing();
         } else {
-          radioControl->radio->unpair();
+          radioControl->unpair();
           memcpy(
             settings->values.peer.address,
             radioControl->radio->peer.address,
@@ -585,8 +732,8 @@ void ControlPannel::handle() {
       case SCREEN_PEER_ADDR:
         if (change) {
           addWithConstrain(settings->values.peer.address[cursor], change, 0x00, 0xff);
-          radioControl->radio->setPeer(&settings->values.peer);
-          radioControl->radio->setRFChannel(settings->values.rfChannel);
+          radioControl->setPeer(&settings->values.peer);
+          radioControl->setRFChannel(settings->values.rfChannel);
           bitSet(flags, FLAG_CURSOR_MOVE);
         }
         break;
@@ -595,15 +742,34 @@ void ControlPannel::handle() {
           settings->values.rfChannel, change, 0, radioControl->radio->getNumRFChannels() - 1
         );
         radioControl->sendRFChannel(settings->values.rfChannel);
-        radioControl->radio->setRFChannel(settings->values.rfChannel);
+        radioControl->setRFChannel(settings->values.rfChannel);
         break;
       case SCREEN_PA_LEVEL:
         addWithConstrain(
           settings->values.paLevel, change, 0, radioControl->radio->getNumPALevels() - 1
         );
         radioControl->sendPALevel(settings->values.paLevel);
-        radioControl->radio->setPALevel(settings->values.paLevel);
+        radioControl->setPALevel(settings->values.paLevel);
+        break;
+#ifdef WITH_RF_SCAN
+      case SCREEN_RF_SCAN:
+        if (!radioControl->canScanRF() || radioControl->rfScan.isRunning()) break;
+        if (change > 0 && bitRead(flags, FLAG_RF_SCAN_RESULT)) {
+          // Confirm proposed channel
+          bitClear(flags, FLAG_RF_SCAN_RESULT);
+          if (radioControl->rfScan.getQuietest() < radioControl->radio->getNumRFChannels()) {
+            settings->values.rfChannel = radioControl->rfScan.getQuietest();
+            radioControl->sendRFChannel(settings->values.rfChannel);
+            radioControl->setRFChannel(settings->values.rfChannel);
+            buzzer->beep(BEEP_LOW_HZ, 250, 0, 1);
+          }
+        } else {
+          bitSet(flags, FLAG_RF_SCANNING);
+          bitClear(flags, FLAG_RF_SCAN_RESULT);
+          radioControl->startScan();
+        }
         break;
+#endif
       case SCREEN_AUTO_CENTER:
         if (change > 0) {
           buzzer->beep(BEEP_LOW_HZ, 500, 0, 1);
@@ -690,6 +856,47 @@ void ControlPannel::handle() {
           NUM_CHANNELS - 1
         );
         break;
+      case SCREEN_MIX_1:
+      case SCREEN_MIX_2:
+      case SCREEN_MIX_3:
+      case SCREEN_MIX_4:
+        mixLine = &settings->values.mixLines[currentScreen - SCREEN_MIX_1];
+        switch (cursor) {
+          case 0:
+            addWithConstrain(mixLine->source, change, 0, MIX_SOURCES_COUNT - 1);
+            break;
+          case 1:
+            addWithConstrain(mixLine->destination, change, NO_CHANNEL, NUM_CHANNELS - 1);
+            break;
+          case 2:
+            // Curves by one, expo by 5%
+            addWithConstrain(
+              mixLine->curve,
+              (mixLine->curve > 0 || (mixLine->curve == 0 && change > 0)) ? change * 5 : change,
+              -MIX_CURVES,
+              100
+            );
+            break;
+          case 3:
+            addWithConstrain(mixLine->weight, change * 5, -100, 100);
+            break;
+          case 4:
+            addWithConstrain(mixLine->offset, change * 5, -100, 100);
+            break;
+          case 5:
+            addWithConstrain(mixLine->condition, change, -SWITCHES_COUNT, SWITCHES_COUNT);
+            break;
+        }
+        break;
+      case SCREEN_CURVE_1:
+      case SCREEN_CURVE_2:
+        addWithConstrain(
+          settings->values.curves[currentScreen - SCREEN_CURVE_1][cursor],
+          change * 5,
+          -100,
+          100
+        );
+        break;
       case SCREEN_BATTERY_LOW:
         addWithConstrain(
           settings->values.batteryLowMV,
@@ -715,6 +922,7 @@ void ControlPannel::handle() {
       case SCREEN_GROUP_RADIO:
       case SCREEN_GROUP_CONTROLS:
       case SCREEN_GROUP_MAPPING:
+      case SCREEN_GROUP_MIXER:
       case SCREEN_GROUP_PEER:
         if (change > 0) moveMenuDown();
         break;
@@ -723,10 +931,29 @@ void ControlPannel::handle() {
         break;
 #endif
     }
+    controls->updateTables();
     needsRedraw = true;
   }
 
   switch (currentScreen) {
+    case SCREEN_MIX_1:
+    case SCREEN_MIX_2:
+    case SCREEN_MIX_3:
+    case SCREEN_MIX_4:
+    case SCREEN_CURVE_1:
+    case SCREEN_CURVE_2:
+      if (now - settingsChangeTime > MIX_CURSOR_INTERVAL) {
+        settingsChangeTime = now;
+        cursor++;
+        if (
+          cursor >= (
+            (currentScreen >= SCREEN_CURVE_1) ? MIX_CURVE_POINTS : MIX_LINE_FIELDS
+          )
+        ) {
+          cursor = 0;
+        }
+      }
+      // fall through, blinks like text fields
     case SCREEN_PROFILE_NAME:
     case SCREEN_PEER_ADDR:
       if (bitRead(flags, FLAG_CURSOR_MOVE) && now - settingsChangeTime > 5000) {
@@ -761,11 +988,58 @@ void ControlPannel::handle() {
       if (cursor != 0) cursor = 0;
   }
 
+  if (bitRead(flags, FLAG_IS_PAIRING)) {
+    if (!radioControl->isPairing()) {
+      bitClear(flags, FLAG_IS_PAIRING);
+      if (radioControl->pairState == PAIR_STATE_PAIRED) {
+        memcpy(
+          settings->values.peer.address,
+          radioControl->radio->peer.address,
+          ADDRESS_LENGTH
+        );
+        buzzer->beep(BEEP_LOW_HZ, 30, 30, 1);
+        settings->values.rfChannel = DEFAULT_RF_CHANNEL;
+      } else {
+        buzzer->beep(BEEP_HIGH_HZ, 5, 30, 5);
+      }
+      needsRedraw = true;
+    } else if (
+        currentScreen == SCREEN_BIND_PEER
+        && now - redrawTime > PROGRESS_REDRAW_INTERVAL
+    ) {
+      needsRedraw = true;
+    }
+  }
+
+#ifdef WITH_RF_SCAN
+  if (bitRead(flags, FLAG_RF_SCANNING)) {
+    if (!radioControl->rfScan.isRunning()) {
+      bitClear(flags, FLAG_RF_SCANNING);
+      bitSet(flags, FLAG_RF_SCAN_RESULT);
+      buzzer->beep(BEEP_LOW_HZ, 30, 30, 1);
+      needsRedraw = true;
+    } else if (
+        currentScreen == SCREEN_RF_SCAN
+        && now - redrawTime > PROGRESS_REDRAW_INTERVAL
+    ) {
+      needsRedraw = true;
+    }
+  }
+#endif
+
   if (now - batteryUpdateTime > BATTERY_MONITOR_INTERVAL) {
     batteryUpdateTime = now;
     thisBatteryMV = voltMetter.readMillivolts();
     PRINT(F("This device battery (mV): "));
     PRINTLN(thisBatteryMV);
+#ifdef WITH_TIMING_STATS
+    handleStats.print(F("ui"));
+    handleStats.reset();
+#endif
+    radioControl->latencyStats.print(F("latency"));
+    controls->loopStats.print(F("loop jitter"));
+    radioControl->latencyStats.reset();
+    controls->loopStats.reset();
     if (
       radioControl->telemetry.batteryMV > 0
       && radioControl->telemetry.batteryMV < settings->values.batteryLowMV
@@ -776,11 +1050,13 @@ void ControlPannel::handle() {
 
   if (
       now - redrawTime > SCREEN_DISPLAY_REDRAW_INTERVAL
-      && currentScreen == SCREEN_DISPLAY
+      && (currentScreen == SCREEN_DISPLAY || currentScreen == SCREEN_TIMING)
   )
     needsRedraw = true;
 
   if (needsRedraw) redrawScreen();
+  display.handle();
+  TIMING_END(handleStats, handleStart);
 }
 
 // vim:ai:sw=2:et
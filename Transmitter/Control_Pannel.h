@@ -3,23 +3,15 @@
 
 #include "Config.h"
 
-#if defined(WITH_ADAFRUIT_SSD1306)
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#elif defined(WITH_SSD1306_ASCII)
-#include <Wire.h>
-#include <SSD1306Ascii.h>
-#include <SSD1306AsciiWire.h>
-#endif
-
 #include <AbleButtons.h>
 #include <LowcostRC_Protocol.h>
 #include <LowcostRC_VoltMetter.h>
+#include <LowcostRC_Stats.h>
 #include "Buzzer.h"
 #include "Radio_Control.h"
 #include "Settings.h"
 #include "Controls.h"
+#include "Text_Display.h"
 
 using Button = AblePullupClickerButton;
 using ButtonList = AblePullupClickerButtonList;
@@ -28,6 +20,7 @@ enum ScreenEnum {
   SCREEN_NULL,
   SCREEN_BLANK,
   SCREEN_DISPLAY,
+  SCREEN_TIMING,
   SCREEN_PROFILE,
   SCREEN_PROFILE_NAME,
 
@@ -36,6 +29,9 @@ enum ScreenEnum {
   SCREEN_PEER_ADDR,
   SCREEN_RF_CHANNEL,
   SCREEN_PA_LEVEL,
+#ifdef WITH_RF_SCAN
+  SCREEN_RF_SCAN,
+#endif
 
   // Controls
   SCREEN_AUTO_CENTER,
@@ -70,6 +66,14 @@ enum ScreenEnum {
   SCREEN_CHANNEL_SWITCH_3,
   SCREEN_CHANNEL_SWITCH_4,
 
+  // Mixer
+  SCREEN_MIX_1,
+  SCREEN_MIX_2,
+  SCREEN_MIX_3,
+  SCREEN_MIX_4,
+  SCREEN_CURVE_1,
+  SCREEN_CURVE_2,
+
   // Peer
   SCREEN_BATTERY_LOW,
   SCREEN_SAVE_FAILSAFE,
@@ -83,6 +87,7 @@ enum ScreenEnum {
   SCREEN_GROUP_RADIO,
   SCREEN_GROUP_CONTROLS,
   SCREEN_GROUP_MAPPING,
+  SCREEN_GROUP_MIXER,
   SCREEN_GROUP_PEER,
   SCREEN_MENU_UP,
 #endif
@@ -105,11 +110,7 @@ class ControlPannel {
 #define currentScreen (*currentMenuItem)
 #endif
 
-#if defined(WITH_ADAFRUIT_SSD1306)
-    Adafruit_SSD1306 display;
-#elif defined(WITH_SSD1306_ASCII)
-    SSD1306AsciiWire display;
-#endif
+    TextDisplay display;
 
     Button screenButton,
            plusButton,
@@ -130,6 +131,11 @@ class ControlPannel {
     void moveMenuDown();
 #endif
   public:
+#ifdef WITH_TIMING_STATS
+    // Time spent in handle(), the longest stall the UI causes
+    TimingStats handleStats;
+#endif
+
     ControlPannel(
       Settings *settings,
       Buzzer *buzzer,
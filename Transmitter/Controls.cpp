@@ -1,10 +1,16 @@
 #include <Arduino.h>
 #include <LowcostRC_Protocol.h>
 #include <LowcostRC_Console.h>
+#include <LowcostRC_ADC.h>
 #include "Config.h"
 #include "Controls.h"
 
 const int CENTER_PULSE = 1500;
+const long JOY_FINE_MAX = 1023L << ADC_FINE_BITS;
+
+// 8 conversions per axis value: 1-2 extra bits after decimation, while a
+// full ADC round stays near 5ms at 125kHz ADC clock
+#define JOY_OVERSAMPLE_BITS 3
 
 const int joystickPins[] = JOYSTICK_PINS;
 const int switchPins[] = SWITCH_PINS;
@@ -13,57 +19,66 @@ Controls::Controls(Settings *settings, Buzzer *buzzer, RadioControl *radioContro
   : settings(settings)
   , buzzer(buzzer)
   , radioControl(radioControl)
+  , sampleSet(0)
+  , mixer(settings)
+  , sampleTime(0)
+  , handleTime(0)
 {
 }
 
 void Controls::begin() {
   for (int axis = 0; axis < AXES_COUNT; axis++) {
     pinMode(joystickPins[axis], INPUT);
+    axisSlots[axis] = ADCSampler::addChannel(joystickPins[axis], 0, JOY_OVERSAMPLE_BITS);
   }
   for (int sw = 0; sw < SWITCHES_COUNT; sw++) {
-    if (!IS_ANALOG_SWITCH(sw))
+    if (!IS_ANALOG_SWITCH(sw)) {
       pinMode(switchPins[sw], INPUT_PULLUP);
+      switchSlots[sw] = ADC_SLOT_NONE;
+    } else {
+      switchSlots[sw] = ADCSampler::addChannel(switchPins[sw]);
+    }
   }
+  ADCSampler::begin();
+  sampleSet = ADCSampler::readSet(samples, &sampleTime) - 1;
+}
+
+// Takes the newest ADC set, axes are remapped only when it changes
+bool Controls::updateSamples() {
+  if (ADCSampler::getSetCount() == sampleSet) return false;
+
+  sampleSet = ADCSampler::readSet(samples, &sampleTime);
+  for (int axis = 0; axis < AXES_COUNT; axis++)
+    axisValues[axis] = readAxis(axis);
+  return true;
 }
 
-int Controls::mapAxis(
-  int joyValue,
-  int joyCenter,
-  int joyThreshold,
-  bool joyInvert,
-  int dualRate,
-  int trimming
-) {
-  int centerPulse = CENTER_PULSE + trimming,
-      minPulse = centerPulse - dualRate,
-      maxPulse = centerPulse + dualRate,
-      pulse = centerPulse;
-
-  if (joyInvert) {
-    joyValue = 1023 - joyValue;
-    joyCenter = 1023 - joyCenter;
+// Precomputes what map() would do for every axis and compiles the mixer;
+// called whenever settings change. Center and threshold are in ADC units
+// as stored in settings, the tables work in fine units.
+void Controls::updateTables() {
+  for (int axis = 0; axis < AXES_COUNT; axis++) {
+    AxisSettings *s = &settings->values.axes[axis];
+
+    compileAxisTable(
+      &axisTables[axis],
+      (long)s->joyCenter << ADC_FINE_BITS,
+      (long)s->joyThreshold << ADC_FINE_BITS,
+      s->joyInvert,
+      s->dualRate,
+      CENTER_PULSE + s->trimming,
+      JOY_FINE_MAX
+    );
   }
 
-  if (joyValue >= joyCenter - joyThreshold && joyValue <= joyCenter + joyThreshold)
-    pulse = centerPulse;
-  else if (joyValue < joyCenter)
-    pulse = map(joyValue, 0, joyCenter - joyThreshold, minPulse, centerPulse);
-  else if (joyValue > joyCenter)
-    pulse = map(joyValue, joyCenter + joyThreshold, 1023, centerPulse, maxPulse);
+  for (int axis = 0; axis < AXES_COUNT; axis++)
+    axisValues[axis] = readAxis(axis);
 
-  return constrain(pulse, 0, 5000);
+  mixer.update();
 }
 
 int Controls::readAxis(Axis axis) {
-  int joyValue = analogRead(joystickPins[axis]);
-  return mapAxis(
-    joyValue,
-    settings->values.axes[axis].joyCenter,
-    settings->values.axes[axis].joyThreshold,
-    settings->values.axes[axis].joyInvert,
-    settings->values.axes[axis].dualRate,
-    settings->values.axes[axis].trimming
-  );
+  return mapAxisTable(&axisTables[axis], samples[axisSlots[axis]], JOY_FINE_MAX);
 }
 
 void Controls::setJoystickCenter() {
@@ -74,7 +89,7 @@ void Controls::setJoystickCenter() {
 
   for (int i = 0; i < count; i++) {
     for (int axis = 0; axis < AXES_COUNT; axis++) {
-      value[axis] += analogRead(joystickPins[axis]);
+      value[axis] += ADCSampler::read(axisSlots[axis]);
     }
     delay(100);
   }
@@ -82,6 +97,7 @@ void Controls::setJoystickCenter() {
   for (int axis = 0; axis < AXES_COUNT; axis++) {
     settings->values.axes[axis].joyCenter = value[axis] / count;
   }
+  updateTables();
 
   PRINTLN(F("DONE"));
 }
@@ -89,8 +105,8 @@ void Controls::setJoystickCenter() {
 int Controls::readSwitch(Switch sw) {
   if (IS_ANALOG_SWITCH(sw)) {
     return map(
-      analogRead(switchPins[sw]),
-      0, 1023,
+      samples[switchSlots[sw]],
+      0, JOY_FINE_MAX,
       settings->values.switches[sw].low, settings->values.switches[sw].high
     );
   }
@@ -104,13 +120,27 @@ int Controls::readSwitch(Switch sw) {
 
 void Controls::handle() {
   union RequestPacket rp;
+  int inputs[MIX_SOURCES_COUNT];
   bool isChanged = false,
        isPing,
        isRetry;
   static int prevChannels[NUM_CHANNELS];
-  unsigned long now = millis();
+  static uint8_t sequence = 0;
+  unsigned long now = millis(),
+                start = micros();
+
+  if (handleTime > 0) {
+    unsigned long period = start - handleTime;
+    loopStats.add(
+      period > CONTROLS_TASK_PERIOD ?
+      period - CONTROLS_TASK_PERIOD : CONTROLS_TASK_PERIOD - period
+    );
+  }
+  handleTime = start;
+
+  if (!radioControl->radio->isPaired() || radioControl->isPairing()) return;
 
-  if (!radioControl->radio->isPaired()) return;
+  updateSamples();
 
   rp.control.packetType = PACKET_TYPE_CONTROL;
 
@@ -118,16 +148,19 @@ void Controls::handle() {
     rp.control.channels[channel] = 0;
   for (int axis = 0; axis < AXES_COUNT; axis++) {
     ChannelN channel = settings->values.axes[axis].channel;
+    inputs[MIX_SOURCE_A_X + axis] = axisValues[axis];
     if (channel != NO_CHANNEL) {
-      rp.control.channels[channel] = readAxis(axis);
+      rp.control.channels[channel] = axisValues[axis];
     }
   }
   for (int sw = 0; sw < SWITCHES_COUNT; sw++) {
     ChannelN channel = settings->values.switches[sw].channel;
+    inputs[MIX_SOURCE_SWITCH_1 + sw] = readSwitch(sw);
     if (channel != NO_CHANNEL) {
-      rp.control.channels[channel] = readSwitch(sw);
+      rp.control.channels[channel] = inputs[MIX_SOURCE_SWITCH_1 + sw];
     }
   }
+  mixer.apply(inputs, rp.control.channels);
 
   for (int channel = 0; channel < NUM_CHANNELS; channel++)
     isChanged = isChanged || rp.control.channels[channel] != prevChannels[channel];
@@ -138,7 +171,7 @@ void Controls::handle() {
   isPing = (
     radioControl->errorTime == 0
     && radioControl->requestSendTime > 0
-    && now - radioControl->requestSendTime > 1000
+    && now - radioControl->requestSendTime > CONTROL_PING_INTERVAL
   );
 
   isRetry = (
@@ -165,7 +198,8 @@ void Controls::handle() {
     PRINTLN();
 #endif
 
-    radioControl->sendPacket(&rp);
+    rp.control.sequence = ++sequence;
+    radioControl->queueControl(&rp, isChanged ? sampleTime : 0);
   }
 }
 
@@ -1,28 +1,41 @@
 #ifndef Controls_h
 #define Controls_h
 
+#include <LowcostRC_ADC.h>
+#include <LowcostRC_Stats.h>
 #include "Types.h"
 #include "Buzzer.h"
 #include "Radio_Control.h"
 #include "Settings.h"
+#include "Mixer.h"
+#include "Axis_Table.h"
 
 class Controls {
   private:
     Settings *settings;
     Buzzer *buzzer;
     RadioControl *radioControl;
+    int8_t axisSlots[AXES_COUNT],
+           switchSlots[SWITCHES_COUNT];
+    // Latest ADC set, fine values by sampler slot
+    uint16_t samples[ADC_SAMPLER_CHANNELS];
+    uint8_t sampleSet;
+    int axisValues[AXES_COUNT];
+    AxisTable axisTables[AXES_COUNT];
+    Mixer mixer;
+
+    bool updateSamples();
   public:
+    // micros() when the stick positions in use were sampled
+    unsigned long sampleTime,
+                  handleTime;
+    // Deviation of handle() call period from CONTROLS_TASK_PERIOD
+    TimingStats loopStats;
+
     Controls(Settings *settings, Buzzer *buzzer, RadioControl *radioControl);
     void begin();
     void setJoystickCenter();
-    int mapAxis(
-      int joyValue,
-      int joyCenter,
-      int joyThreshold,
-      bool joyInvert,
-      int dualRate,
-      int trimming
-    );
+    void updateTables();
     int readAxis(Axis axis);
     int readSwitch(Switch sw);
     void handle();
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include "Mixer.h"
+
+#define MIX_CENTER_PULSE 1500
+// Input and output span of 100%
+#define MIX_RANGE 500
+#define MIX_CURVE_STEP (2 * MIX_RANGE / (MIX_CURVE_POINTS - 1))
+
+Mixer::Mixer(Settings *settings)
+  : settings(settings)
+{
+}
+
+// Converts percents of settings once, so apply() only multiplies and
+// shifts; called whenever settings change
+void Mixer::update() {
+  for (int i = 0; i < MIX_LINES; i++) {
+    const MixLine *s = &settings->values.mixLines[i];
+    MixerLine *line = &lines[i];
+
+    line->source = s->source;
+    line->curve = s->curve;
+    line->destination = s->destination;
+    line->condition = s->condition;
+    line->expo = (s->curve > 0) ? (s->curve * 256L) / 100 : 0;
+    line->weight = (s->weight * 256L) / 100;
+    line->offset = (s->offset * (long)MIX_RANGE) / 100;
+  }
+
+  for (int curve = 0; curve < MIX_CURVES; curve++)
+    for (int point = 0; point < MIX_CURVE_POINTS; point++)
+      curves[curve][point] = (settings->values.curves[curve][point] * (long)MIX_RANGE) / 100;
+}
+
+bool Mixer::isActive(const MixerLine *line, const int *inputs) {
+  if (line->destination == NO_CHANNEL) return false;
+  if (line->condition == 0) return true;
+
+  int sw = abs(line->condition) - 1,
+      value = inputs[MIX_SOURCE_SWITCH_1 + sw],
+      low = settings->values.switches[sw].low,
+      high = settings->values.switches[sw].high;
+  bool isHigh = abs(value - high) < abs(value - low);
+
+  return (line->condition > 0) == isHigh;
+}
+
+// x is the offset from center pulse, linear lines pass any range,
+// expo and curves work within +-MIX_RANGE
+int Mixer::shape(const MixerLine *line, int x) {
+  long x2, x3;
+  int segment, pos;
+  const int16_t *points;
+
+  if (line->curve == 0) return x;
+  x = constrain(x, -MIX_RANGE, MIX_RANGE);
+
+  if (line->curve > 0) {
+    // x^3 / MIX_RANGE^2, 131 / 65536 ~ 1 / MIX_RANGE
+    x2 = ((long)x * x * 131) >> 16;
+    x3 = (x2 * x * 131) >> 16;
+    return x + (((x3 - x) * line->expo) >> 8);
+  }
+
+  points = curves[-line->curve - 1];
+  if (x >= MIX_RANGE) return points[MIX_CURVE_POINTS - 1];
+  pos = x + MIX_RANGE;
+  for (segment = 0; pos >= MIX_CURVE_STEP; segment++) pos -= MIX_CURVE_STEP;
+  // 262 / 65536 ~ 1 / MIX_CURVE_STEP
+  return points[segment]
+    + (((long)(points[segment + 1] - points[segment]) * pos * 262) >> 16);
+}
+
+// Lines driving a channel replace its direct mapping and add up
+void Mixer::apply(const int *inputs, uint16_t *channels) {
+  int mixed[NUM_CHANNELS];
+  uint8_t driven = 0;
+
+  for (int i = 0; i < MIX_LINES; i++) {
+    const MixerLine *line = &lines[i];
+    int out;
+
+    if (!isActive(line, inputs)) continue;
+
+    out = shape(line, inputs[line->source] - MIX_CENTER_PULSE);
+    out = (((long)out * line->weight) >> 8) + line->offset;
+    if (!bitRead(driven, line->destination)) {
+      bitSet(driven, line->destination);
+      mixed[line->destination] = MIX_CENTER_PULSE;
+    }
+    mixed[line->destination] += out;
+  }
+
+  for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+    if (bitRead(driven, channel))
+      channels[channel] = constrain(mixed[channel], 0, 5000);
+  }
+}
+
+// vim:ai:sw=2:et
@@ -0,0 +1,33 @@
+#ifndef Mixer_h
+#define Mixer_h
+
+#include <LowcostRC_Protocol.h>
+#include "Settings.h"
+
+// Mix line compiled from MixLine, in microseconds and Q8 factors
+struct MixerLine {
+  int8_t source,
+         curve,
+         destination,
+         condition;
+  int16_t expo,
+          weight,
+          offset;
+};
+
+class Mixer {
+  private:
+    Settings *settings;
+    MixerLine lines[MIX_LINES];
+    int16_t curves[MIX_CURVES][MIX_CURVE_POINTS];
+
+    bool isActive(const MixerLine *line, const int *inputs);
+    int shape(const MixerLine *line, int x);
+  public:
+    Mixer(Settings *settings);
+    void update();
+    void apply(const int *inputs, uint16_t *channels);
+};
+
+#endif // Mixer_h
+// vim:ai:sw=2:et
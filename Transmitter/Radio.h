@@ -4,6 +4,15 @@
 #include <LowcostRC_Protocol.h>
 #include <LowcostRC_Tx.h>
 
+enum PairStateEnum {
+  PAIR_STATE_IDLE,
+  PAIR_STATE_PAIRING,
+  PAIR_STATE_PAIRED,
+  PAIR_STATE_FAILED,
+};
+
+typedef uint8_t PairState;
+
 class BaseRadioModule {
   public:
     Address peer;
@@ -19,7 +28,17 @@ class BaseRadioModule {
     virtual bool setPALevel(PALevel level) = 0;
     virtual bool receive(union ResponsePacket *packet) = 0;
     virtual bool send(const union RequestPacket *packet) = 0;
-    virtual bool pair() = 0;
+    // Pairing is stepped by handlePairing() until it returns
+    // PAIR_STATE_PAIRED or PAIR_STATE_FAILED, steps must not block
+    virtual void startPairing() = 0;
+    virtual PairState handlePairing() = 0;
+    virtual unsigned int getPairingTimeout() = 0;
+
+    // Carrier detection for RF scan, radio returns to the link channel
+    virtual bool canScanRF() { return false; };
+    virtual bool isChannelBusy(RFChannel ch) { return false; };
+    // Responses arrive with the acknowledgement of a sent packet
+    virtual bool isResponseInAck() { return false; };
 
     bool isPaired();
     void unpair();
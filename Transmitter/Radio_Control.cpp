@@ -1,32 +1,131 @@
 #include <LowcostRC_Console.h>
 #include "Radio_Control.h"
 
+#define LINK_STATS_PACKETS 100
+
+// Channels sampled per handle() call, about 250us each, must fit in
+// RADIO_TASK_BUDGET together with the packet exchange
+#define RF_SCAN_STEP_CHANNELS 1
+
+#define PING_INTERVAL 1000
+#define PACKET_RATE_INTERVAL 1000
+
+bool LinkStats::count(bool isSent) {
+  packetsCount++;
+  if (!isSent) packetsFailureCount++;
+
+  if (packetsCount < LINK_STATS_PACKETS) return false;
+
+  linkQuality = 100 - packetsFailureCount;
+  packetsCount = 0;
+  packetsFailureCount = 0;
+  return true;
+}
+
 RadioControl::RadioControl(Buzzer *buzzer) : radio(NULL), buzzer(buzzer) {
+#ifdef WITH_DUAL_RADIO
+  secondary = NULL;
+  pathQuality[0] = pathQuality[1] = 0;
+#endif
+#ifdef WITH_RF_SCAN
+  scanRadio = NULL;
+#endif
   telemetry.batteryMV = 0;
 }
 
+BaseRadioModule *RadioControl::probe(BaseRadioModule *module) {
+  if (module->begin()) return module;
+  delete module;
+  return NULL;
+}
+
 void RadioControl::begin() {
   radio = NULL;
-#ifdef WITH_RADIO_NRF24
+#ifdef WITH_DUAL_RADIO
+  // ESP-NOW link is primary: its peer is the receiver MAC address,
+  // which the diversity receiver also gives to the nRF24 path
+  radio = probe(new SPIRadioModule());
+  // Diversity receiver does not acknowledge on secondary paths
+  NRF24RadioModule *nrf24 = new NRF24RadioModule();
+  nrf24->setAutoAck(false);
+  secondary = probe(nrf24);
   if (!radio) {
-    radio = new NRF24RadioModule();
-    if (!radio->begin()) {
-      delete radio;
-      radio = NULL;
-    }
+    radio = secondary;
+    secondary = NULL;
   }
+#else
+#ifdef WITH_RADIO_NRF24
+  if (!radio) radio = probe(new NRF24RadioModule());
 #endif
 #ifdef WITH_RADIO_SPI
-  if (!radio) {
-    radio = new SPIRadioModule();
-    if (!radio->begin()) {
-      delete radio;
-      radio = NULL;
-    }
-  }
+  if (!radio) radio = probe(new SPIRadioModule());
+#endif
+#endif
+#ifdef WITH_RF_SCAN
+  if (radio && radio->canScanRF()) scanRadio = radio;
+#ifdef WITH_DUAL_RADIO
+  if (!scanRadio && secondary && secondary->canScanRF()) scanRadio = secondary;
+#endif
+#endif
+}
+
+void RadioControl::setPeer(const Address *addr) {
+  if (isPairing()) return;
+  radio->setPeer(addr);
+#ifdef WITH_DUAL_RADIO
+  if (secondary) secondary->setPeer(addr);
+#endif
+}
+
+void RadioControl::setRFChannel(RFChannel ch) {
+  if (isPairing()) return;
+  radio->setRFChannel(ch);
+#ifdef WITH_DUAL_RADIO
+  if (secondary) secondary->setRFChannel(ch);
+#endif
+}
+
+void RadioControl::setPALevel(PALevel level) {
+  radio->setPALevel(level);
+#ifdef WITH_DUAL_RADIO
+  if (secondary) secondary->setPALevel(level);
+#endif
+}
+
+void RadioControl::startPairing() {
+  radio->startPairing();
+  pairState = PAIR_STATE_PAIRING;
+  pairStartTime = millis();
+}
+
+bool RadioControl::isPairing() {
+  return pairState == PAIR_STATE_PAIRING;
+}
+
+uint8_t RadioControl::getPairingProgress() {
+  if (!isPairing()) return 0;
+  return min((millis() - pairStartTime) * 100 / radio->getPairingTimeout(), 100);
+}
+
+void RadioControl::unpair() {
+  radio->unpair();
+#ifdef WITH_DUAL_RADIO
+  if (secondary) secondary->unpair();
 #endif
 }
 
+#ifdef WITH_RF_SCAN
+bool RadioControl::canScanRF() {
+  return scanRadio != NULL;
+}
+
+void RadioControl::startScan() {
+  if (!scanRadio) return;
+  sendCommand(COMMAND_SCAN_RF);
+  rfScan.start();
+}
+#endif
+
 void RadioControl::sendRFChannel(RFChannel channel) {
   union RequestPacket rp;
   rp.rfChannel.packetType = PACKET_TYPE_SET_RF_CHANNEL;
@@ -48,30 +147,86 @@ void RadioControl::sendCommand(Command command) {
   sendPacket(&rp);
 }
 
+void RadioControl::sendPing() {
+  union RequestPacket rp;
+
+  if (isPairing()) return;
+
+  PRINTLN(F("Sending ping"));
+  rp.ping.packetType = PACKET_TYPE_PING;
+  // Stamped after console output, which takes milliseconds
+  pingTxTime = micros();
+  rp.ping.txTime = pingTxTime;
+  transmit(&rp);
+  pingExchangeTime = sendEndTime - pingTxTime;
+}
+
+// Acknowledgement payloads wait at the receiver for the next packet, so
+// round trip is that of the ping exchange itself. Otherwise the receiver
+// hold time is taken out, arrival time is off by up to a scheduler period.
+void RadioControl::handlePong(const struct PongPacket *pong, bool isInAck) {
+  if (pong->txTime != pingTxTime) return;
+
+  if (isInAck) {
+    rtt = pingExchangeTime;
+  } else {
+    rtt = (micros() - pong->txTime) - (pong->replyTime - pong->rxTime);
+  }
+  clockOffset = (long)(pong->rxTime - pong->txTime) - (long)(rtt / 2);
+
+  PRINT(F("RTT (us): "));
+  PRINT(rtt);
+  PRINT(F("; clock offset (us): "));
+  PRINT(clockOffset);
+  PRINT(F("; packets/s: "));
+  PRINTLN(packetRate);
+}
+
+void RadioControl::queueControl(
+    const union RequestPacket *packet, unsigned long sampleTime
+) {
+  memcpy(&controlPacket, packet, sizeof(controlPacket));
+  // Latency counts from the oldest unsent change
+  if (!hasControlPacket || controlSampleTime == 0)
+    controlSampleTime = sampleTime;
+  hasControlPacket = true;
+}
+
 void RadioControl::sendPacket(const union RequestPacket *packet) {
-  unsigned long now = millis();
+  // Radio is busy with pairing handshake
+  if (isPairing()) return;
 
   PRINT(F("Sending packet type: "));
   PRINT(packet->generic.packetType);
   PRINT(F("; size: "));
   PRINTLN(sizeof(*packet));
 
-  packetsCount++;
+  transmit(packet);
+}
 
-  if (radio->send(packet)) {
+void RadioControl::transmit(const union RequestPacket *packet) {
+  unsigned long now = millis();
+  bool isSent = radio->send(packet);
+
+#ifdef WITH_DUAL_RADIO
+  // Receiver takes the first copy. Secondary is not acknowledged, so
+  // delivery is known only from the primary link.
+  if (secondary) secondary->send(packet);
+#endif
+  sendEndTime = micros();
+
+  if (isSent) {
     requestSendTime = now;
     errorTime = 0;
+    rateCount++;
   } else {
     if (errorTime == 0) errorTime = now;
     requestSendTime = 0;
-    packetsFailureCount++;
   }
 
-  if (packetsCount == 100) {
+  if (stats.count(isSent)) {
     prevLinkQuality = linkQuality;
-    linkQuality = 100 - packetsFailureCount;
-    packetsCount = 0;
-    packetsFailureCount = 0;
+    linkQuality = stats.linkQuality;
     if (linkQuality < MIN_LINK_QUALITY) {
       buzzer->beep(BEEP_HIGH_HZ, 5, 5, 1);
     } else if (prevLinkQuality < MIN_LINK_QUALITY) {
@@ -88,13 +243,105 @@ void RadioControl::handle() {
     errorTime = 0;
   }
 
-  if (radio->receive(&response)) {
+  if (isPairing()) {
+    pairState = radio->handlePairing();
+#ifdef WITH_DUAL_RADIO
+    if (pairState == PAIR_STATE_PAIRED && secondary) {
+      secondary->setPeer(&radio->peer);
+      secondary->setRFChannel(DEFAULT_RF_CHANNEL);
+    }
+#endif
+    return;
+  }
+
+  // One radio exchange per pass, pings wait for a pass without frame
+  bool isControlSent = hasControlPacket;
+  if (hasControlPacket) {
+    hasControlPacket = false;
+    sendPacket(&controlPacket);
+    if (controlSampleTime > 0)
+      latencyStats.add(micros() - controlSampleTime);
+  }
+
+#ifdef WITH_RF_SCAN
+  for (uint8_t i = 0; i < RF_SCAN_STEP_CHANNELS && rfScan.isRunning(); i++)
+    rfScan.add(scanRadio->isChannelBusy(rfScan.getChannel()));
+#endif
+
+  BaseRadioModule *source = radio;
+  bool isReceived = radio->receive(&response);
+#ifdef WITH_DUAL_RADIO
+  if (!isReceived && secondary) {
+    source = secondary;
+    isReceived = secondary->receive(&response);
+  }
+#endif
+
+  if (isReceived) {
     if (response.telemetry.packetType == PACKET_TYPE_TELEMETRY) {
       memcpy(&telemetry, &response.telemetry, sizeof(TelemetryPacket));
       telemetryTime = now;
       PRINT(F("Peer device battery (mV): "));
       PRINTLN(telemetry.batteryMV);
     }
+    else if (response.pong.packetType == PACKET_TYPE_PONG) {
+      handlePong(&response.pong, source->isResponseInAck());
+    }
+#ifdef WITH_RF_SCAN
+    else if (response.rfScan.packetType == PACKET_TYPE_RF_SCAN) {
+      rfScan.merge(
+        response.rfScan.firstChannel,
+        response.rfScan.hits,
+        RF_SCAN_PACKET_CHANNELS
+      );
+    }
+#endif
+#if defined(WITH_CONSOLE) || defined(WITH_DUAL_RADIO)
+    else if (response.sensors.packetType == PACKET_TYPE_SENSORS) {
+      for (uint8_t i = 0; i < SENSORS_PACKET_VALUES; i++) {
+        SensorType type = response.sensors.values[i].type;
+
+        if (type == SENSOR_TYPE_NONE) continue;
+#ifdef WITH_DUAL_RADIO
+        if (type >= SENSOR_TYPE_PATH_QUALITY && type < SENSOR_TYPE_PATH_QUALITY + 2)
+          pathQuality[type - SENSOR_TYPE_PATH_QUALITY] = response.sensors.values[i].value;
+#endif
+        PRINT(F("Peer sensor "));
+        PRINT(type);
+        PRINT(F(": "));
+        PRINTLN(response.sensors.values[i].value);
+      }
+    }
+#endif
+#ifdef WITH_CONSOLE
+    else if (response.timingStats.packetType == PACKET_TYPE_TIMING_STATS) {
+      PRINT(F("Peer timing probe "));
+      PRINT(response.timingStats.probe);
+      PRINT(F(": min: "));
+      PRINT(response.timingStats.minValue);
+      PRINT(F("; avg: "));
+      PRINT(response.timingStats.avgValue);
+      PRINT(F("; max: "));
+      PRINT(response.timingStats.maxValue);
+      PRINT(F("; hist:"));
+      for (uint8_t i = 0; i < TIMING_STATS_PACKET_BUCKETS; i++) {
+        PRINT(F(" "));
+        PRINT(response.timingStats.buckets[i]);
+      }
+      PRINTLN();
+    }
+#endif
+  }
+
+  if (now - rateTime >= PACKET_RATE_INTERVAL) {
+    packetRate = (unsigned long)rateCount * 1000 / (now - rateTime);
+    rateCount = 0;
+    rateTime = now;
+  }
+
+  if (!isControlSent && radio->isPaired() && now - pingTime > PING_INTERVAL) {
+    pingTime = now;
+    sendPing();
   }
 }
 
@@ -2,25 +2,73 @@
 #define Radio_Control_h
 
 #include <LowcostRC_Protocol.h>
+#include <LowcostRC_RFScan.h>
+#include <LowcostRC_Stats.h>
 #include "Radio.h"
 #include "Radio_NRF24.h"
 #include "Radio_SPI.h"
 #include "Buzzer.h"
 #include "Config.h"
 
+struct LinkStats {
+  byte packetsFailureCount = 0,
+       packetsCount = 0,
+       linkQuality = 0;
+
+  bool count(bool isSent);
+};
+
 class RadioControl {
   private:
     Buzzer *buzzer;
-    byte packetsFailureCount = 0,
-        packetsCount = 0,
-        prevLinkQuality = 0;
+    LinkStats stats;
+    byte prevLinkQuality = 0;
+    unsigned long pairStartTime = 0,
+                  pingTime = 0,
+                  pingTxTime = 0,
+                  pingExchangeTime = 0,
+                  sendEndTime = 0,
+                  rateTime = 0,
+                  controlSampleTime = 0;
+    uint16_t rateCount = 0;
+    union RequestPacket controlPacket;
+    bool hasControlPacket = false;
+
+    // Sends without console output, sets sendEndTime
+    void transmit(const union RequestPacket *packet);
+    void sendPing();
+    void handlePong(const struct PongPacket *pong, bool isInAck);
+
+    BaseRadioModule *probe(BaseRadioModule *module);
+#ifdef WITH_RF_SCAN
+    BaseRadioModule *scanRadio;
+#endif
   public:
     BaseRadioModule *radio;
+#ifdef WITH_DUAL_RADIO
+    // Sends the same frames as radio, uses its peer address
+    BaseRadioModule *secondary;
+    // Percent of frames the receiver got by each link, from its sensor
+    // telemetry, primary first
+    uint8_t pathQuality[2];
+#endif
     struct TelemetryPacket telemetry;
     unsigned long requestSendTime = 0,
                   telemetryTime = 0,
                   errorTime = 0;
     byte linkQuality = 0;
+    // Round trip time and receiver clock minus transmitter clock, us
+    unsigned long rtt = 0;
+    long clockOffset = 0;
+    // Delivered packets per second
+    uint16_t packetRate = 0;
+    // Stick sample to sent frame, for frames carrying a change
+    TimingStats latencyStats;
+    PairState pairState = PAIR_STATE_IDLE;
+#ifdef WITH_RF_SCAN
+    // Transmitter and receiver measurements added together
+    RFScan rfScan;
+#endif
 
     RadioControl(Buzzer *buzzer);
     void begin();
@@ -28,6 +76,23 @@ class RadioControl {
     void sendPALevel(PALevel level);
     void sendCommand(Command command);
     void sendPacket(const union RequestPacket *packet);
+    // Control frame is sent from handle(), so the radio exchange is
+    // budgeted in the radio task. A newer frame replaces an unsent one.
+    // sampleTime is 0 for frames without change.
+    void queueControl(const union RequestPacket *packet, unsigned long sampleTime);
+    void setPeer(const Address *addr);
+    void setRFChannel(RFChannel ch);
+    void setPALevel(PALevel level);
+    void startPairing();
+    bool isPairing();
+    // Elapsed part of the pairing timeout, percent
+    uint8_t getPairingProgress();
+#ifdef WITH_RF_SCAN
+    bool canScanRF();
+    // Asks the receiver to scan as well, link stays up meanwhile
+    void startScan();
+#endif
+    void unpair();
     void handle();
 };
 
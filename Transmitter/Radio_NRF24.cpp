@@ -15,8 +15,14 @@
 
 #define NRF24_NUM_PA_LEVELS (RF24_PA_MAX-RF24_PA_MIN+1)
 
+#define NRF24_PAIR_TIMEOUT 3000
+
+// Receiver must listen this long (us) before RPD is valid
+#define NRF24_RPD_TIME 170
+
 NRF24RadioModule::NRF24RadioModule()
-  : rf24(RADIO_NRF24_CE_PIN, RADIO_NRF24_CSN_PIN)
+  : rf24(RADIO_NRF24_CE_PIN, RADIO_NRF24_CSN_PIN),
+    isAutoAck(true)
 {
 }
 
@@ -29,11 +35,19 @@ bool NRF24RadioModule::begin() {
   PRINTLN(F("NRF24: init: OK"));
   rf24.setRadiation(RF24_PA_MIN, NRF24_DATA_RATE);
   rf24.setPayloadSize(PACKET_SIZE);
-  rf24.enableAckPayload();
-  rf24.setRetries(5, 3);
+  if (isAutoAck) {
+    rf24.enableAckPayload();
+    rf24.setRetries(5, 3);
+  } else {
+    rf24.enableDynamicAck();
+  }
   return true;
 }
 
+void NRF24RadioModule::setAutoAck(bool value) {
+  isAutoAck = value;
+}
+
 TxModuleType NRF24RadioModule::getModuleType() {
   return MODULE_TYPE_NRF24L01;
 }
@@ -56,7 +70,7 @@ bool NRF24RadioModule::setPeer(const Address *addr) {
   memcpy(&peer, addr, sizeof(peer));
   rf24.stopListening();
   rf24.openWritingPipe(peer.address);
-  rf24.enableAckPayload();
+  if (isAutoAck) rf24.enableAckPayload();
   return true;
 }
 
@@ -87,54 +101,79 @@ bool NRF24RadioModule::receive(union ResponsePacket *packet) {
 }
 
 bool NRF24RadioModule::send(const union RequestPacket *packet) {
-    return rf24.write(packet, sizeof(RequestPacket));
+  // Without acknowledgement only the transmission itself is reported
+  return rf24.write(packet, sizeof(RequestPacket), !isAutoAck);
 }
 
-bool NRF24RadioModule::pair() {
+void NRF24RadioModule::startPairing() {
   Address broadcast = ADDRESS_BROADCAST;
-  RequestPacket req, resp;
 
   rf24.stopListening();
   rf24.openWritingPipe(broadcast.address);
   rf24.enableAckPayload();
   rf24.setChannel(NRF24_DEFAULT_CHANNEL);
 
-  req.pair.packetType = PACKET_TYPE_PAIR;
-  req.pair.session = random(1 << 15);
-  req.pair.status = PAIR_STATUS_INIT;
+  pairRequest.pair.packetType = PACKET_TYPE_PAIR;
+  pairRequest.pair.session = random(1 << 15);
+  pairRequest.pair.status = PAIR_STATUS_INIT;
+  pairStartTime = millis();
 
   PRINT(F("NRF24: Starting pairing session: "));
-  PRINTLN(req.pair.session);
-
-  for (
-    unsigned long start = millis();
-    millis() - start < 3000;
-    delay(5)
-  ) {
-    rf24.write(&req, sizeof(req));
-    if (rf24.isAckPayloadAvailable()) {
-      rf24.read(&resp, sizeof(resp));
-      if (
-          resp.pair.packetType == PACKET_TYPE_PAIR
-          && resp.pair.session == req.pair.session
-          && resp.pair.status == PAIR_STATUS_READY
-      ) {
-          PRINTLN(F("NRF24: Paired"));
-          memcpy(&peer, &resp.pair.sender, sizeof(peer));
-          req.pair.status = PAIR_STATUS_PAIRED;
-          rf24.write(&req, sizeof(req));
-          rf24.openWritingPipe(peer.address);
-          rf24.setChannel(NRF24_DEFAULT_CHANNEL);
-          return true;
-      }
-    }
+  PRINTLN(pairRequest.pair.session);
+}
+
+// Every step sends one INIT request, receiver answers with READY in the
+// ack payload of one of the next requests
+PairState NRF24RadioModule::handlePairing() {
+  RequestPacket resp;
+
+  if (millis() - pairStartTime > NRF24_PAIR_TIMEOUT) {
+    PRINTLN(F("NRF24: Not paired"));
+    rf24.openWritingPipe(peer.address);
+    rf24.setChannel(rfChannelToNRF24(rfChannel));
+    return PAIR_STATE_FAILED;
   }
 
-  PRINTLN(F("NRF24: Not paired"));
+  rf24.write(&pairRequest, sizeof(pairRequest));
+  if (!rf24.isAckPayloadAvailable())
+    return PAIR_STATE_PAIRING;
+
+  rf24.read(&resp, sizeof(resp));
+  if (
+      resp.pair.packetType != PACKET_TYPE_PAIR
+      || resp.pair.session != pairRequest.pair.session
+      || resp.pair.status != PAIR_STATUS_READY
+  )
+    return PAIR_STATE_PAIRING;
+
+  PRINTLN(F("NRF24: Paired"));
+  memcpy(&peer, &resp.pair.sender, sizeof(peer));
+  pairRequest.pair.status = PAIR_STATUS_PAIRED;
+  rf24.write(&pairRequest, sizeof(pairRequest));
   rf24.openWritingPipe(peer.address);
-  rf24.setChannel(rfChannelToNRF24(rfChannel));
+  rfChannel = DEFAULT_RF_CHANNEL;
+  rf24.setChannel(NRF24_DEFAULT_CHANNEL);
+  return PAIR_STATE_PAIRED;
+}
 
-  return false;
+unsigned int NRF24RadioModule::getPairingTimeout() {
+  return NRF24_PAIR_TIMEOUT;
+}
+
+bool NRF24RadioModule::canScanRF() {
+  return true;
+}
+
+bool NRF24RadioModule::isChannelBusy(RFChannel ch) {
+  bool isBusy;
+
+  rf24.setChannel(ch);
+  rf24.startListening();
+  delayMicroseconds(NRF24_RPD_TIME);
+  isBusy = rf24.testRPD();
+  rf24.stopListening();
+  rf24.setChannel(rfChannelToNRF24(rfChannel));
+  return isBusy;
 }
 
 // vim:ai:sw=2:et
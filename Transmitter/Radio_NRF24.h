@@ -7,6 +7,9 @@
 class NRF24RadioModule : public BaseRadioModule {
   private:
     RF24 rf24;
+    RequestPacket pairRequest;
+    unsigned long pairStartTime;
+    bool isAutoAck;
     uint8_t rfChannelToNRF24(RFChannel ch);
   public:
     NRF24RadioModule();
@@ -19,7 +22,15 @@ class NRF24RadioModule : public BaseRadioModule {
     virtual bool setPALevel(PALevel level);
     virtual bool receive(union ResponsePacket *telemetry);
     virtual bool send(const union RequestPacket *packet);
-    virtual bool pair();
+    virtual void startPairing();
+    virtual PairState handlePairing();
+    virtual unsigned int getPairingTimeout();
+    virtual bool canScanRF();
+    virtual bool isChannelBusy(RFChannel ch);
+    virtual bool isResponseInAck() { return isAutoAck; };
+    // Disable to send to a secondary path of diversity receiver, which
+    // does not acknowledge. Call before begin().
+    void setAutoAck(bool value);
 };
 
 #endif	//Radio_NRF24_h
@@ -3,9 +3,11 @@
 #include <LowcostRC_Console.h>
 #include <LowcostRC_SPI.h>
 
+#include "Config.h"
 #include "Radio_SPI.h"
 
-#define SS_PIN 10
+#define SS_PIN RADIO_SPI_SS_PIN
+#define SPI_CLOCK 2000000
 #define INIT_TIMEOUT 2000
 #define INIT_RETRY_COUNT 5
 #define INIT_RETRY_PAUSE 500
@@ -22,40 +24,57 @@ void SPIRadioModule::pulseSS() {
     digitalWrite(SS_PIN, LOW);
 }
 
-uint32_t SPIRadioModule::readStatus() {
+// Bus may be shared with nRF24, which uses own SPI settings
+void SPIRadioModule::select() {
+  SPI.beginTransaction(SPISettings(SPI_CLOCK, MSBFIRST, SPI_MODE0));
+  pulseSS();
+}
+
+// SS idles LOW, it is GPIO15 boot strap pin of the bridge. With dual
+// radio the bridge must release MISO for nRF24, see Config.h.
+void SPIRadioModule::deselect() {
+#ifdef WITH_DUAL_RADIO
+  digitalWrite(SS_PIN, HIGH);
+#else
   pulseSS();
+#endif
+  SPI.endTransaction();
+}
+
+uint32_t SPIRadioModule::readStatus() {
+  select();
   SPI.transfer(0x04);
   uint32_t status = (SPI.transfer(0) | ((uint32_t)(SPI.transfer(0)) << 8) | ((uint32_t)(SPI.transfer(0)) << 16) | ((uint32_t)(SPI.transfer(0)) << 24));
-  pulseSS();
+  deselect();
   return status;
 }
 
 void SPIRadioModule::writeStatus(uint32_t status) {
-  pulseSS();
+  select();
   SPI.transfer(0x01);
   SPI.transfer(status & 0xFF);
   SPI.transfer((status >> 8) & 0xFF);
   SPI.transfer((status >> 16) & 0xFF);
   SPI.transfer((status >> 24) & 0xFF);
-  pulseSS();
+  deselect();
 }
 
 void SPIRadioModule::readData(uint8_t *data) {
-  pulseSS();
+  select();
   SPI.transfer(0x03);
   SPI.transfer(0x00);
   for (uint8_t i = 0; i < SPI_PACKET_SIZE; i++) { data[i] = SPI.transfer(0); }
-  pulseSS();
+  deselect();
 }
 
 void SPIRadioModule::writeData(uint8_t *data, size_t len) {
   uint8_t i = 0;
-  pulseSS();
+  select();
   SPI.transfer(0x02);
   SPI.transfer(0x00);
   while (len-- && i < SPI_PACKET_SIZE) { SPI.transfer(data[i++]); }
   while (i++ < SPI_PACKET_SIZE) { SPI.transfer(0); }
-  pulseSS();
+  deselect();
 }
 
 bool SPIRadioModule::begin() {
@@ -63,6 +82,9 @@ bool SPIRadioModule::begin() {
   SPIResponsePacket resp;
 
   pinMode(SS_PIN, OUTPUT);
+#ifdef WITH_DUAL_RADIO
+  digitalWrite(SS_PIN, HIGH);
+#endif
   SPI.begin();
 
 
@@ -197,32 +219,37 @@ bool SPIRadioModule::send(const union RequestPacket *packet) {
   return sendGeneric(packet, sizeof(RequestPacket), SPI_STATUS_TRANSMITING);
 }
 
-bool SPIRadioModule::pair() {
-  ResponsePacket resp;
-
+void SPIRadioModule::startPairing() {
   PRINTLN(F("SPI: Starting pairing"));
   writeStatus(SPI_STATUS_PAIRING);
+  pairStartTime = millis();
+}
 
-  for (
-      unsigned long start = millis();
-      millis() - start < PAIR_TIMEOUT;
-      delay(1)
-  ) {
-    if (!receiveGeneric(&resp, sizeof(ResponsePacket), SPI_STATUS_PAIRED))
-      continue;
-    if (resp.pair.packetType != PACKET_TYPE_PAIR)
-      continue;
-    if (resp.pair.status != PAIR_STATUS_READY)
-      continue;
-    PRINTLN(F("SPI: Paired"));
-    memcpy(peer.address, resp.pair.sender.address, ADDRESS_LENGTH);
+// Bridge runs the handshake, each step only polls its status
+PairState SPIRadioModule::handlePairing() {
+  ResponsePacket resp;
+
+  if (millis() - pairStartTime > PAIR_TIMEOUT) {
+    PRINTLN(F("SPI: Not paired"));
     writeStatus(SPI_STATUS_OK);
-    return true;
+    return PAIR_STATE_FAILED;
   }
 
-  PRINTLN(F("SPI: Not paired"));
-  writeStatus(SPI_STATUS_OK);
-  return false;
+  if (
+      !receiveGeneric(&resp, sizeof(ResponsePacket), SPI_STATUS_PAIRED)
+      || resp.pair.packetType != PACKET_TYPE_PAIR
+      || resp.pair.status != PAIR_STATUS_READY
+  )
+    return PAIR_STATE_PAIRING;
+
+  PRINTLN(F("SPI: Paired"));
+  memcpy(peer.address, resp.pair.sender.address, ADDRESS_LENGTH);
+  rfChannel = DEFAULT_RF_CHANNEL;
+  return PAIR_STATE_PAIRED;
+}
+
+unsigned int SPIRadioModule::getPairingTimeout() {
+  return PAIR_TIMEOUT;
 }
 
 // vim:et:sw=2:ai
@@ -9,8 +9,11 @@ class SPIRadioModule : public BaseRadioModule {
     TxModuleType moduleType;
     uint8_t numRFChannels,
             numPALevels;
+    unsigned long pairStartTime;
 
     void pulseSS();
+    void select();
+    void deselect();
     uint32_t readStatus();
     void writeStatus(uint32_t status);
     void readData(uint8_t *data);
@@ -28,7 +31,9 @@ class SPIRadioModule : public BaseRadioModule {
     virtual bool setPALevel(PALevel level);
     virtual bool receive(union ResponsePacket *packet);
     virtual bool send(const union RequestPacket *packet);
-    virtual bool pair();
+    virtual void startPairing();
+    virtual PairState handlePairing();
+    virtual unsigned int getPairingTimeout();
 };
 
 #endif	//Radio_SPI_h
@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include "Scheduler.h"
+
+Scheduler::Scheduler()
+  : numTasks(0)
+#ifdef WITH_TIMING_STATS
+  , statsTime(0)
+#endif
+{
+}
+
+// Tasks are kept sorted by priority, equal priorities in order added
+bool Scheduler::addTask(
+  const __FlashStringHelper *name,
+  TaskFunction run,
+  unsigned long period,
+  uint8_t priority,
+  unsigned long budget
+) {
+  uint8_t i;
+
+  if (numTasks >= SCHEDULER_MAX_TASKS) return false;
+
+  for (i = numTasks; i > 0 && tasks[i - 1].priority > priority; i--)
+    tasks[i] = tasks[i - 1];
+
+  memset(&tasks[i], 0, sizeof(Task));
+  tasks[i].name = name;
+  tasks[i].run = run;
+  tasks[i].period = period;
+  tasks[i].priority = priority;
+  tasks[i].budget = budget;
+  tasks[i].lastRun = micros() - period;
+  numTasks++;
+  return true;
+}
+
+void Scheduler::runTask(Task *task, unsigned long now) {
+  unsigned long late = now - task->lastRun - task->period;
+
+  // Keep cadence, unless so late that catching up would burst
+  if (late < task->period) {
+    task->lastRun += task->period;
+  } else {
+    task->lastRun = now;
+  }
+
+  task->run();
+
+#ifdef WITH_TIMING_STATS
+  unsigned long runTime = micros() - now;
+
+  task->runTime += runTime;
+  task->runs++;
+  task->maxRunTime = max(task->maxRunTime, min(runTime, 0xffffUL));
+  task->maxLate = max(task->maxLate, min(late, 0xffffUL));
+  if (runTime > task->budget) task->overruns++;
+#endif
+}
+
+void Scheduler::handle() {
+  unsigned long now = micros(),
+                slack = 0xffffffffUL,
+                elapsed;
+
+  for (uint8_t i = 0; i < numTasks; i++) {
+    Task *task = &tasks[i];
+
+    elapsed = now - task->lastRun;
+    if (elapsed >= task->period) {
+      if (task->budget <= slack || elapsed >= 2 * task->period) {
+        runTask(task, now);
+        break;
+      }
+      slack = 0;
+    } else {
+      slack = min(slack, task->period - elapsed);
+    }
+  }
+
+#if defined(WITH_TIMING_STATS) && defined(WITH_CONSOLE)
+  if (millis() - statsTime > SCHEDULER_STATS_INTERVAL) printStats();
+#endif
+}
+
+#ifdef WITH_TIMING_STATS
+// Prints run time of tasks since last call, then starts over. Share is
+// of wall time, the rest is idle looping.
+void Scheduler::printStats() {
+  unsigned long interval = millis() - statsTime;
+
+  statsTime = millis();
+
+  for (uint8_t i = 0; i < numTasks; i++) {
+    Task *task = &tasks[i];
+
+    PRINT(F("task "));
+    PRINT(task->name);
+    PRINT(F(": n: "));
+    PRINT(task->runs);
+    PRINT(F("; avg: "));
+    PRINT(task->runs > 0 ? task->runTime / task->runs : 0);
+    PRINT(F("; max: "));
+    PRINT(task->maxRunTime);
+    PRINT(F("; share: "));
+    PRINT(interval > 0 ? task->runTime / (interval * 10) : 0);
+    PRINT(F("%; late max: "));
+    PRINT(task->maxLate);
+    PRINT(F("; overruns: "));
+    PRINTLN(task->overruns);
+
+    task->runTime = 0;
+    task->runs = 0;
+    task->maxRunTime = 0;
+    task->maxLate = 0;
+    task->overruns = 0;
+  }
+}
+#endif
+
+// vim:ai:sw=2:et
@@ -0,0 +1,57 @@
+#ifndef Scheduler_h
+#define Scheduler_h
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 6
+#define SCHEDULER_STATS_INTERVAL 5000
+
+typedef void (*TaskFunction)();
+
+struct Task {
+  const __FlashStringHelper *name;
+  TaskFunction run;
+  // Microseconds
+  unsigned long period,
+                budget,
+                lastRun;
+  uint8_t priority;
+#ifdef WITH_TIMING_STATS
+  unsigned long runTime;
+  uint16_t runs,
+           maxRunTime,
+           maxLate,
+           overruns;
+#endif
+};
+
+// Cooperative scheduler: runs one due task per handle() call, highest
+// priority (lowest number) first. A lower priority task only starts when
+// its budget fits before the next run of every higher priority task, or
+// when it is late by a whole period.
+class Scheduler {
+  private:
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t numTasks;
+#ifdef WITH_TIMING_STATS
+    unsigned long statsTime;
+#endif
+
+    void runTask(Task *task, unsigned long now);
+  public:
+    Scheduler();
+    bool addTask(
+      const __FlashStringHelper *name,
+      TaskFunction run,
+      unsigned long period,
+      uint8_t priority,
+      unsigned long budget
+    );
+    void handle();
+#ifdef WITH_TIMING_STATS
+    void printStats();
+#endif
+};
+
+#endif // Scheduler_h
+// vim:ai:sw=2:et
@@ -4,10 +4,17 @@
 #include <LowcostRC_Console.h>
 #include "Settings.h"
 
-#define SETTINGS_MAGICK 0x555b
+#define SETTINGS_MAGICK 0x555c
 #define PROFILES_ADDR 0
 #define SETTINGS_SIZE sizeof(SettingsValues)
 
+#ifdef E2END
+static_assert(
+  PROFILES_ADDR + NUM_PROFILES * SETTINGS_SIZE <= E2END + 1,
+  "Profiles don't fit EEPROM"
+);
+#endif
+
 #define DEFAULT_BATTERY_LOW_MV  3400
 #define DEFAULT_JOY_CENTER      512
 #define DEFAULT_JOY_THRESHOLD   1
@@ -16,6 +23,8 @@
 #define DEFAULT_TRIMMING        0
 #define DEFAULT_SWITCH_LOW      1000
 #define DEFAULT_SWITCH_HIGH     2000
+#define DEFAULT_MIX_LINE        {MIX_SOURCE_A_X, 0, 100, 0, NO_CHANNEL, 0}
+#define DEFAULT_CURVE           {-100, -50, 0, 50, 100}
 
 const SettingsValues defaultSettingsValues PROGMEM = {
   SETTINGS_MAGICK,
@@ -81,6 +90,17 @@ const SettingsValues defaultSettingsValues PROGMEM = {
       DEFAULT_SWITCH_HIGH,
       CHANNEL8
     }
+  },
+  // mixer
+  {
+    DEFAULT_MIX_LINE,
+    DEFAULT_MIX_LINE,
+    DEFAULT_MIX_LINE,
+    DEFAULT_MIX_LINE
+  },
+  {
+    DEFAULT_CURVE,
+    DEFAULT_CURVE
   }
 };
 
@@ -6,6 +6,10 @@
 
 #define NUM_PROFILES 8
 
+#define MIX_LINES 4
+#define MIX_CURVES 2
+#define MIX_CURVE_POINTS 5
+
 struct AxisSettings {
   uint16_t joyCenter,
            joyThreshold;
@@ -20,6 +24,32 @@ struct SwitchesSettings {
   ChannelN channel;
 } __attribute__((__packed__));
 
+// Mixer sources: axes first, then switches
+enum MixSourceEnum {
+  MIX_SOURCE_A_X,
+  MIX_SOURCE_A_Y,
+  MIX_SOURCE_B_X,
+  MIX_SOURCE_B_Y,
+  MIX_SOURCE_SWITCH_1,
+  MIX_SOURCE_SWITCH_2,
+  MIX_SOURCE_SWITCH_3,
+  MIX_SOURCE_SWITCH_4,
+  MIX_SOURCES_COUNT,
+};
+
+// Line is off when destination is NO_CHANNEL.
+// curve: 0 linear, 1..100 expo %, -1..-MIX_CURVES multi-point curve.
+// weight and offset: % of 500us. condition: 0 always, n or -n switch n
+// high or low.
+struct MixLine {
+  uint8_t source;
+  int8_t curve,
+         weight,
+         offset,
+         destination,
+         condition;
+} __attribute__((__packed__));
+
 struct SettingsValues {
   uint16_t magick;
   char profileName[8];
@@ -29,6 +59,9 @@ struct SettingsValues {
   uint16_t batteryLowMV;
   AxisSettings axes[AXES_COUNT];
   SwitchesSettings switches[SWITCHES_COUNT];
+  MixLine mixLines[MIX_LINES];
+  // Points at -100, -50, 0, 50, 100% of input, in % of output
+  int8_t curves[MIX_CURVES][MIX_CURVE_POINTS];
 } __attribute__((__packed__));
 
 class Settings {
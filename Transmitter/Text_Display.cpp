@@ -0,0 +1,225 @@
+#include <Arduino.h>
+#include <LowcostRC_Console.h>
+#include "Text_Display.h"
+
+// Wire buffer minus the data control byte
+#define I2C_DATA_CHUNK 31
+
+#define CLEAR_CHUNK_WIDTH (DISPLAY_WIDTH / TEXT_CLEAR_CHUNKS)
+
+// Device address and control byte of every I2C transaction
+#define I2C_OVERHEAD_BYTES 2
+#if defined(WITH_ADAFRUIT_SSD1306)
+// Page and column window, six commands in one transaction
+#define WINDOW_BYTES (I2C_OVERHEAD_BYTES + 6)
+#elif defined(WITH_SSD1306_ASCII)
+// SSD1306Ascii sends every command in its own transaction, setCursor()
+// takes three
+#define CURSOR_BYTES (3 * (I2C_OVERHEAD_BYTES + 1))
+#endif
+
+// Adafruit library sets clkAfter after every command, page data written
+// directly to Wire must stay at full speed too
+#define I2C_CLOCK 400000UL
+
+TextDisplay::TextDisplay()
+#if defined(WITH_ADAFRUIT_SSD1306)
+  : display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1, I2C_CLOCK, I2C_CLOCK)
+  , dirtyPages(0)
+  , sendCol(1)
+  , sendTo(0)
+  , scale(0)
+#elif defined(WITH_SSD1306_ASCII)
+  : display()
+  , scale(0)
+#else
+  : scale(0)
+#endif
+{
+}
+
+void TextDisplay::begin() {
+#if defined(WITH_ADAFRUIT_SSD1306)
+  if (!display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_ADDRESS)) {
+    PRINTLN(F("SSD1306 init FAIL"));
+  } else {
+    PRINTLN(F("SSD1306 init OK"));
+  };
+  display.clearDisplay();
+  display.display();
+#elif defined(WITH_SSD1306_ASCII)
+  Wire.begin();
+  Wire.setClock(I2C_CLOCK);
+  display.begin(&Adafruit128x64, DISPLAY_ADDRESS);
+  display.setFont(System5x7);
+  display.clear();
+  memset(clearChunks, 0, sizeof(clearChunks));
+#endif
+  scale = 1;
+  memset(cells, ' ', sizeof(cells));
+#if defined(WITH_SSD1306_ASCII)
+  memset(dirtyCells, 0, sizeof(dirtyCells));
+#endif
+}
+
+// Blank display and cells, needed when the cell grid changes
+void TextDisplay::clear(uint8_t newScale) {
+  scale = newScale;
+  memset(cells, ' ', sizeof(cells));
+#if defined(WITH_ADAFRUIT_SSD1306)
+  display.fillRect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, BLACK);
+  for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+    dirtyFrom[page] = 0;
+    dirtyTo[page] = DISPLAY_WIDTH - 1;
+  }
+  dirtyPages = 0xff;
+#elif defined(WITH_SSD1306_ASCII)
+  memset(dirtyCells, 0, sizeof(dirtyCells));
+  memset(clearChunks, 0xff, sizeof(clearChunks));
+  if (scale == 1) {
+    display.set1X();
+  } else {
+    display.set2X();
+  }
+#endif
+}
+
+void TextDisplay::putCell(uint8_t row, uint8_t col, char c) {
+  if (cells[row][col] == c) return;
+  cells[row][col] = c;
+
+#if defined(WITH_ADAFRUIT_SSD1306)
+  uint8_t x = col * TEXT_CELL_WIDTH * scale;
+
+  display.drawChar(x, row * TEXT_CELL_HEIGHT * scale, c, WHITE, BLACK, scale);
+  for (uint8_t page = row * scale; page < (row + 1) * scale; page++) {
+    if (!bitRead(dirtyPages, page)) {
+      bitSet(dirtyPages, page);
+      dirtyFrom[page] = x;
+      dirtyTo[page] = x + TEXT_CELL_WIDTH * scale - 1;
+    } else {
+      dirtyFrom[page] = min(dirtyFrom[page], x);
+      dirtyTo[page] = max(dirtyTo[page], x + TEXT_CELL_WIDTH * scale - 1);
+    }
+  }
+#elif defined(WITH_SSD1306_ASCII)
+  bitSet(dirtyCells[row][col / 8], col % 8);
+#endif
+}
+
+// Lays text out the way print() would and queues the cells that differ
+// from what is on the display
+void TextDisplay::draw(const char *text, bool isSmall) {
+  uint8_t newScale = isSmall ? 1 : 2,
+          rows = TEXT_ROWS / newScale,
+          cols = TEXT_COLUMNS / newScale,
+          row = 0,
+          col = 0;
+
+  if (newScale != scale) clear(newScale);
+
+  while (row < rows) {
+    char c = *text;
+
+    if (c && c != '\n') {
+      if (col >= cols) {
+        row++;
+        col = 0;
+        if (row >= rows) break;
+      }
+      putCell(row, col++, c);
+      text++;
+    } else {
+      while (col < cols) putCell(row, col++, ' ');
+      row++;
+      col = 0;
+      if (c) text++;
+    }
+  }
+}
+
+// Sends up to TEXT_DISPLAY_FLUSH_BYTES of queued changes. Smallest unit
+// is sent even if it does not fit, e.g. a large SSD1306Ascii character.
+void TextDisplay::handle() {
+  int budget = TEXT_DISPLAY_FLUSH_BYTES,
+      count;
+
+#if defined(WITH_ADAFRUIT_SSD1306)
+  uint8_t *buffer = display.getBuffer();
+
+  while (true) {
+    if (sendCol > sendTo) {
+      if (dirtyPages == 0) return;
+      if (budget < WINDOW_BYTES + I2C_OVERHEAD_BYTES + 1) return;
+      // Cells changed meanwhile get their page queued again, so taking
+      // the span now is safe
+      for (sendPage = 0; !bitRead(dirtyPages, sendPage); sendPage++);
+      bitClear(dirtyPages, sendPage);
+      sendCol = dirtyFrom[sendPage];
+      sendTo = dirtyTo[sendPage];
+
+      Wire.beginTransmission(DISPLAY_ADDRESS);
+      Wire.write((uint8_t)0x00);
+      Wire.write((uint8_t)SSD1306_PAGEADDR);
+      Wire.write(sendPage);
+      Wire.write(sendPage);
+      Wire.write((uint8_t)SSD1306_COLUMNADDR);
+      Wire.write(sendCol);
+      Wire.write(sendTo);
+      Wire.endTransmission();
+      budget -= WINDOW_BYTES;
+    }
+
+    count = min(min(I2C_DATA_CHUNK, sendTo - sendCol + 1), budget - I2C_OVERHEAD_BYTES);
+    if (count <= 0) return;
+    Wire.beginTransmission(DISPLAY_ADDRESS);
+    Wire.write((uint8_t)0x40);
+    Wire.write(buffer + sendPage * DISPLAY_WIDTH + sendCol, count);
+    Wire.endTransmission();
+    // Column 255 can't be reached, no wrap around
+    sendCol += count;
+    budget -= count + I2C_OVERHEAD_BYTES;
+  }
+#elif defined(WITH_SSD1306_ASCII)
+  uint8_t width = TEXT_CELL_WIDTH * scale,
+          nextCol;
+
+  // Cells are drawn only after clearing is complete
+  for (uint8_t i = 0; i < DISPLAY_PAGES * TEXT_CLEAR_CHUNKS; i++) {
+    uint8_t page = i / TEXT_CLEAR_CHUNKS,
+            chunk = i % TEXT_CLEAR_CHUNKS;
+
+    if (!bitRead(clearChunks[i / 8], i % 8)) continue;
+    count = CURSOR_BYTES + I2C_OVERHEAD_BYTES + CLEAR_CHUNK_WIDTH;
+    if (count > budget && budget < TEXT_DISPLAY_FLUSH_BYTES) return;
+    bitClear(clearChunks[i / 8], i % 8);
+    display.clear(
+      chunk * CLEAR_CHUNK_WIDTH, (chunk + 1) * CLEAR_CHUNK_WIDTH - 1, page, page
+    );
+    budget -= count;
+  }
+
+  for (uint8_t row = 0; row < TEXT_ROWS / scale; row++) {
+    // Small characters next to each other need no cursor move
+    nextCol = 0xff;
+    for (uint8_t col = 0; col < TEXT_COLUMNS / scale; col++) {
+      if (!bitRead(dirtyCells[row][col / 8], col % 8)) continue;
+      if (scale == 1) {
+        count = col == nextCol ? width : CURSOR_BYTES + I2C_OVERHEAD_BYTES + width;
+      } else {
+        // Large ones move the cursor between their pages and back
+        count = (scale - 1) * 2 * CURSOR_BYTES + scale * (I2C_OVERHEAD_BYTES + width);
+        if (col != nextCol) count += CURSOR_BYTES;
+      }
+      if (count > budget && budget < TEXT_DISPLAY_FLUSH_BYTES) return;
+      bitClear(dirtyCells[row][col / 8], col % 8);
+      if (col != nextCol) display.setCursor(col * width, row * scale);
+      display.write(cells[row][col]);
+      nextCol = col + 1;
+      budget -= count;
+    }
+  }
+#endif
+}
+
+// vim:ai:sw=2:et
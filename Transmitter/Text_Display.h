@@ -0,0 +1,65 @@
+#ifndef Text_Display_h
+#define Text_Display_h
+
+#include "Config.h"
+
+#if defined(WITH_ADAFRUIT_SSD1306)
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#elif defined(WITH_SSD1306_ASCII)
+#include <Wire.h>
+#include <SSD1306Ascii.h>
+#include <SSD1306AsciiWire.h>
+#endif
+
+// 5x7 font cells, doubled in large font
+#define TEXT_CELL_WIDTH  6
+#define TEXT_CELL_HEIGHT 8
+#define TEXT_COLUMNS     (DISPLAY_WIDTH / TEXT_CELL_WIDTH)
+#define TEXT_ROWS        (DISPLAY_HEIGHT / TEXT_CELL_HEIGHT)
+#define DISPLAY_PAGES    (DISPLAY_HEIGHT / 8)
+
+// I2C time per byte at 400kHz, us
+#define I2C_BYTE_TIME 23
+// I2C bytes sent per handle() call, counting addresses and display
+// commands, so the flush takes about 5/6 of UI_TASK_BUDGET
+#define TEXT_DISPLAY_FLUSH_BYTES (UI_TASK_BUDGET * 5 / 6 / I2C_BYTE_TIME)
+// Page parts cleared separately, so one clear fits the flush bytes
+#define TEXT_CLEAR_CHUNKS 8
+
+// Text screen that remembers drawn characters and only updates the cells
+// that changed. draw() only queues changes, handle() sends them a bounded
+// chunk at a time.
+class TextDisplay {
+  private:
+#if defined(WITH_ADAFRUIT_SSD1306)
+    Adafruit_SSD1306 display;
+    // Changed column span of every page in the frame buffer
+    uint8_t dirtyPages,
+            dirtyFrom[DISPLAY_PAGES],
+            dirtyTo[DISPLAY_PAGES],
+            sendPage,
+            sendCol,
+            sendTo;
+#elif defined(WITH_SSD1306_ASCII)
+    SSD1306AsciiWire display;
+    uint8_t dirtyCells[TEXT_ROWS][(TEXT_COLUMNS + 7) / 8],
+            // Page chunks left to clear, bit per chunk
+            clearChunks[DISPLAY_PAGES * TEXT_CLEAR_CHUNKS / 8];
+#endif
+    char cells[TEXT_ROWS][TEXT_COLUMNS];
+    uint8_t scale;
+
+    void clear(uint8_t newScale);
+    void putCell(uint8_t row, uint8_t col, char c);
+  public:
+    TextDisplay();
+    void begin();
+    // Lines are separated by \n and wrap at the display width
+    void draw(const char *text, bool isSmall);
+    void handle();
+};
+
+#endif // Text_Display_h
+// vim:ai:sw=2:et
@@ -5,6 +5,7 @@
 #include "Settings.h"
 #include "Control_Pannel.h"
 #include "Controls.h"
+#include "Scheduler.h"
 #include "Config.h"
 
 Buzzer buzzer;
@@ -12,6 +13,12 @@ RadioControl radioControl(&buzzer);
 Settings settings;
 Controls controls(&settings, &buzzer, &radioControl);
 ControlPannel controlPannel(&settings, &buzzer, &radioControl, &controls);
+Scheduler scheduler;
+
+void runControls() { controls.handle(); }
+void runRadioControl() { radioControl.handle(); }
+void runControlPannel() { controlPannel.handle(); }
+void runBuzzer() { buzzer.handle(); }
 
 void setup(void)
 {
@@ -31,13 +38,16 @@ void setup(void)
   if (!settings.isLoaded) {
     controls.setJoystickCenter();
   }
+
+  // Control frames go first, UI fills the gaps between them
+  scheduler.addTask(F("controls"), runControls, CONTROLS_TASK_PERIOD, 0, CONTROLS_TASK_BUDGET);
+  scheduler.addTask(F("radio"), runRadioControl, RADIO_TASK_PERIOD, 1, RADIO_TASK_BUDGET);
+  scheduler.addTask(F("buzzer"), runBuzzer, BUZZER_TASK_PERIOD, 2, BUZZER_TASK_BUDGET);
+  scheduler.addTask(F("ui"), runControlPannel, UI_TASK_PERIOD, 3, UI_TASK_BUDGET);
 }
 
 void loop(void) {
-  controls.handle();
-  radioControl.handle();
-  controlPannel.handle();
-  buzzer.handle();
+  scheduler.handle();
 }
 
 // vim:ai:sw=2:et
@@ -164,6 +164,7 @@ void controlLoop(unsigned long now) {
   union RequestPacket rp;
   bool isChanged = false;
   static int prevChannels[NUM_CHANNELS];
+  static uint8_t sequence = 0;
 
   rp.control.packetType = PACKET_TYPE_CONTROL;
 
@@ -207,7 +208,7 @@ void controlLoop(unsigned long now) {
 
   if (
     isChanged
-    || (requestSendTime > 0 && now - requestSendTime > 1000)
+    || (requestSendTime > 0 && now - requestSendTime > CONTROL_PING_INTERVAL)
   ) {
     PRINT(F("ch1: "));
     PRINT(rp.control.channels[CHANNEL1]);
@@ -218,6 +219,7 @@ void controlLoop(unsigned long now) {
     PRINT(F("; ch4: "));
     PRINTLN(rp.control.channels[CHANNEL4]);
 
+    rp.control.sequence = ++sequence;
     sendRequest(now, &rp);
     requestSendTime = now;
   }
@@ -12,11 +12,15 @@
 #define RANDOM_SEED_PIN A0
 #define ESP8266_DEFAULT_CHANNEL 11
 #define ESP8266_NUM_CHANNELS 12
+#define PAIR_INIT_INTERVAL 20
 
 Address peer = ADDRESS_NONE;
 RFChannel rfChannel = DEFAULT_RF_CHANNEL;
 
 uint16_t pairSession = 0;
+unsigned long pairInitTime = 0;
+bool isPairConfirming = false;
+ResponsePacket pairResponse;
 
 bool blinkState = false;
 unsigned long blinkTime = 0;
@@ -48,8 +52,16 @@ void onSPIStatus(uint32_t status) {
     blinkDuration = 50;
     blinkPause = 50;
     pairSession = random(1, 1 << 15);
+    isPairConfirming = false;
+    pairInitTime = millis();
     sendPairInitPacket(pairSession);
   }
+  else if (status == SPI_STATUS_OK && pairSession) {
+    // Transmitter gave up pairing
+    PRINTLN("Pairing canceled");
+    blinkCount = 0;
+    pairSession = 0;
+  }
 }
 
 void onSPIDataRecv(uint8_t *data, size_t len) {
@@ -98,6 +110,22 @@ void onSPIDataRecv(uint8_t *data, size_t len) {
 }
 
 void onESPNowDataSent(uint8_t *mac_addr, uint8_t sendStatus) {
+  if (pairSession) {
+    // Pair status is reported only after the receiver got the notification,
+    // broadcast pair requests are not tracked
+    if (isPairConfirming && memcmp(mac_addr, peer.address, ADDRESS_LENGTH) == 0) {
+      isPairConfirming = false;
+      if (sendStatus == ESP_OK) {
+        PRINTLN("ESP: Paired");
+        blinkCount = 0;
+        pairSession = 0;
+        SPISlave.setData((uint8_t*)&pairResponse, sizeof(ResponsePacket));
+        SPISlave.setStatus(SPI_STATUS_PAIRED);
+      }
+    }
+    return;
+  }
+
   if (sendStatus == ESP_OK) {
     PRINTLN("ESP: delivery OK");
     SPISlave.setStatus(SPI_STATUS_OK);
@@ -144,14 +172,8 @@ void onESPNowDataRecv(uint8_t * mac,  uint8_t *incomingData, uint8_t len) {
       esp_now_set_peer_channel(peer.address, rfChannelToWifi(rfChannel));
     }
 
-    if (sendPaired(pairSession)) {;
-      PRINTLN("ESP: Paired");
-      blinkCount = 0;
-      pairSession = 0;
-      SPISlave.setData((uint8_t*)&resp, sizeof(ResponsePacket));
-      SPISlave.setStatus(SPI_STATUS_PAIRED);
-      delay(100);
-    }
+    memcpy(&pairResponse, &resp, sizeof(ResponsePacket));
+    isPairConfirming = sendPaired(pairSession);
     return;
   }
 
@@ -250,6 +272,13 @@ void setup() {
 
 void loop() {
   unsigned long now = millis();
+
+  // Receiver may enter pairing later than transmitter, repeat the request
+  if (pairSession && !isPairConfirming && now - pairInitTime > PAIR_INIT_INTERVAL) {
+    pairInitTime = now;
+    sendPairInitPacket(pairSession);
+  }
+
   controlBlink(now);
 }
 
@@ -0,0 +1,99 @@
+// Host check that Transmitter axis tables map every fine ADC value exactly
+// like the former map() based Controls::mapAxis, for a spread of settings.
+//
+//   g++ -O2 -o axis_table_check tools/axis_table_check.cpp
+//   ./axis_table_check
+//
+// Table code works in uint32_t and stays within 32 bits, so host int and
+// long widths give the same results as AVR. The reference below uses
+// AVR widths explicitly.
+#include <stdio.h>
+#include <stdint.h>
+#include "../Transmitter/Axis_Table.h"
+
+// Same as in LowcostRC_ADC.h and Transmitter/Controls.cpp
+#define ADC_FINE_BITS 4
+const int32_t CENTER_PULSE = 1500;
+const int32_t JOY_FINE_MAX = 1023L << ADC_FINE_BITS;
+
+// Arduino map() with AVR long
+static int32_t map(int32_t x, int32_t inMin, int32_t inMax, int32_t outMin, int32_t outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+static int16_t mapAxis(
+  int16_t joyValue,
+  int16_t joyCenter,
+  int16_t joyThreshold,
+  bool joyInvert,
+  int16_t dualRate,
+  int16_t trimming
+) {
+  int32_t value = (uint16_t)joyValue,
+          center = (int32_t)joyCenter << ADC_FINE_BITS,
+          threshold = (int32_t)joyThreshold << ADC_FINE_BITS;
+  int16_t centerPulse = CENTER_PULSE + trimming,
+          minPulse = centerPulse - dualRate,
+          maxPulse = centerPulse + dualRate,
+          pulse = centerPulse;
+
+  if (joyInvert) {
+    value = JOY_FINE_MAX - value;
+    center = JOY_FINE_MAX - center;
+  }
+
+  if (value >= center - threshold && value <= center + threshold)
+    pulse = centerPulse;
+  else if (value < center)
+    pulse = map(value, 0, center - threshold, minPulse, centerPulse);
+  else if (value > center)
+    pulse = map(value, center + threshold, JOY_FINE_MAX, centerPulse, maxPulse);
+
+  if (pulse < 0) return 0;
+  if (pulse > 5000) return 5000;
+  return pulse;
+}
+
+int main() {
+  // Limits as in Control_Pannel.cpp, plus edge centers
+  static const int16_t centers[] = {0, 1, 2, 100, 300, 511, 512, 513, 700, 1000, 1021, 1022, 1023},
+                       thresholds[] = {0, 1, 2, 5, 20, 100},
+                       dualRates[] = {10, 20, 100, 333, 500, 777, 1000, 1250, 1490, 1500},
+                       trimmings[] = {-1500, -255, 0, 5, 600, 1500};
+  unsigned long combos = 0,
+                mismatches = 0;
+  AxisTable t;
+
+  for (int16_t center : centers)
+    for (int16_t threshold : thresholds)
+      for (int invert = 0; invert < 2; invert++)
+        for (int16_t dualRate : dualRates)
+          for (int16_t trimming : trimmings) {
+            compileAxisTable(
+              &t,
+              (long)center << ADC_FINE_BITS,
+              (long)threshold << ADC_FINE_BITS,
+              invert,
+              dualRate,
+              CENTER_PULSE + trimming,
+              JOY_FINE_MAX
+            );
+            combos++;
+            for (int32_t value = 0; value <= JOY_FINE_MAX; value++) {
+              int expected = mapAxis(value, center, threshold, invert, dualRate, trimming),
+                  actual = mapAxisTable(&t, value, JOY_FINE_MAX);
+
+              if (expected == actual) continue;
+              if (mismatches++ < 10)
+                printf(
+                  "center %d threshold %d invert %d dualRate %d trimming %d value %d: "
+                  "expected %d, got %d\n",
+                  center, threshold, invert, dualRate, trimming, value, expected, actual
+                );
+            }
+          }
+
+  printf("%lu settings, %lu mismatches\n", combos, mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
+// vim:ai:sw=2:et